@@ -26,7 +26,7 @@ void setup() {
   Serial.println("\n");
   Serial.println("*TH: Initializing in 5 seconds...");
   delay(5000);
-  thx = THiNX(apikey); // 4. initialize with API Key
+  thx.init(apikey); // 4. initialize with API Key (thx is global, never copied)
 }
 
 void loop()
@@ -0,0 +1,66 @@
+// Counts how many array elements and object members fit in a 1 KB
+// StaticJsonBuffer and how much arena each corpus document takes; built once
+// with ARDUINOJSON_COMPACT_NODES and once without. Floats are used as on the
+// ESP8266, pointers stay 64-bit, so the devices gain somewhat more.
+
+#include <ArduinoJson.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ArduinoJson;
+
+static int array_elements() {
+  StaticJsonBuffer<1024> buffer;
+  JsonArray & array = buffer.createArray();
+  int n = 0;
+  while (array.add(n)) n++;
+  return n;
+}
+
+static int object_members() {
+  static char keys[256][5];
+  StaticJsonBuffer<1024> buffer;
+  JsonObject & object = buffer.createObject();
+  int n = 0;
+  for (; n < 256; n++) {
+    snprintf(keys[n], sizeof(keys[n]), "k%d", n);
+    if (!object.set(keys[n], n)) break;  // keys are not copied
+  }
+  return n;
+}
+
+int main(int argc, char ** argv) {
+  printf("COMPACT_NODES %d: array node %zu bytes, object node %zu bytes\n", ARDUINOJSON_COMPACT_NODES,
+         sizeof(Internals::ListNode<JsonVariant>), sizeof(Internals::ListNode<JsonPair>));
+  printf("  1 KB StaticJsonBuffer: %d array elements, %d object members\n", array_elements(), object_members());
+
+  std::string corpus = (argc > 1) ? argv[1] : "corpus";
+  DIR * dir = opendir(corpus.c_str());
+  if (dir == NULL) {
+    printf("no corpus at %s\n", corpus.c_str());
+    return 1;
+  }
+  std::vector<std::string> names;
+  while (struct dirent * entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if ((name.size() > 5) && (name.compare(name.size() - 5, 5, ".json") == 0)) names.push_back(name);
+  }
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+
+  for (size_t i = 0; i < names.size(); i++) {
+    std::ifstream file((corpus + "/" + names[i]).c_str(), std::ios::binary);
+    std::stringstream payload;
+    payload << file.rdbuf();
+    std::string text = payload.str();
+    StaticJsonBuffer<32768> buffer;
+    bool ok = buffer.parseObject(&text[0]).success(); // in place, strings take no arena
+    printf("  %-18s %5zu bytes of arena%s\n", names[i].c_str(), buffer.size(), ok ? "" : " (parse failed)");
+  }
+  return 0;
+}
@@ -0,0 +1,113 @@
+// Routes device topics to 1..100 command handlers, through THiNXDispatcher
+// and through a list of filters matched one by one
+
+#include <THiNXDispatcher.h>
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+static const char * prefix = "/cedc16bb6bb06daaa3ff6d30666d91aacd6e3efbf9abbc151b4dcade59af7c12/"
+                             "d2d7b050-7c53-11e7-b94e-15f5f3a64973";
+
+static unsigned long calls = 0;
+
+static void handler(const char *, const uint8_t *, size_t, void *) {
+  calls++;
+}
+
+// MQTT filter match, + and # included
+static bool matches(const char * filter, const char * topic) {
+  while (*filter) {
+    if (*filter == '#') return true;
+    if (*filter == '+') {
+      while (*topic && (*topic != '/')) topic++;
+      filter++;
+      continue;
+    }
+    if (*filter != *topic) {
+      return (*topic == '\0') && (strcmp(filter, "/#") == 0); // "a/#" matches "a"
+    }
+    filter++;
+    topic++;
+  }
+  return *topic == '\0';
+}
+
+struct route_t {
+  std::string filter;
+  thinx_handler_t func;
+};
+
+static unsigned long linear(const std::vector<route_t> & routes, const char * topic) {
+  unsigned long called = 0;
+  for (size_t i = 0; i < routes.size(); i++) {
+    if (matches(routes[i].filter.c_str(), topic)) {
+      routes[i].func(topic, NULL, 0, NULL);
+      called++;
+    }
+  }
+  return called;
+}
+
+template <typename F>
+static double ns_per_call(F f, int n) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < n; i++) f(i);
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n;
+}
+
+int main() {
+
+  const int counts[] = { 1, 2, 5, 10, 20, 50, 100 };
+  const int N = 200000;
+
+  printf("commands  trie ns  list ns  (nodes, per dispatch over all commands and a miss)\n");
+
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+
+    static THiNXDispatcher dispatcher;     // 1 KB+ with the bench limits
+    dispatcher.clear();
+    std::vector<route_t> routes;
+
+    // Built-in routes of THiNX, then the application commands
+    const char * builtin[] = { "", "/update", "/notification", "/rpc/in", "/shadow/desired",
+                               "/command/reboot", "/command/config" };
+    for (size_t i = 0; i < sizeof(builtin) / sizeof(builtin[0]); i++) {
+      route_t route = { std::string(prefix) + builtin[i], handler };
+      routes.push_back(route);
+    }
+    std::vector<std::string> topics;
+    for (int i = 0; i < counts[c]; i++) {
+      char name[32];
+      snprintf(name, sizeof(name), "/command/app-%d", i);
+      route_t route = { std::string(prefix) + name, handler };
+      routes.push_back(route);
+      topics.push_back(route.filter);
+    }
+    topics.push_back(std::string(prefix) + "/command/unknown");
+
+    for (size_t i = 0; i < routes.size(); i++) {
+      if (!dispatcher.add(routes[i].filter.c_str(), routes[i].func)) {
+        printf("out of dispatcher capacity at %zu routes\n", i);
+        return 1;
+      }
+    }
+
+    calls = 0;
+    double trie = ns_per_call([&](int i) {
+      const char * topic = topics[i % topics.size()].c_str();
+      dispatcher.dispatch(topic, NULL, 0);
+    }, N);
+    unsigned long trie_calls = calls;
+
+    calls = 0;
+    double list = ns_per_call([&](int i) {
+      linear(routes, topics[i % topics.size()].c_str());
+    }, N);
+
+    printf("%8d %8.1f %8.1f  (%u%s)\n", counts[c], trie, list, dispatcher.nodes(),
+           (trie_calls == calls) ? "" : ", MISMATCH");
+  }
+  return 0;
+}
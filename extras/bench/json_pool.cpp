@@ -0,0 +1,212 @@
+// Parses the corpus documents a million times against a 24 KB first-fit
+// heap, with one long-lived application block churned per cycle, and counts
+// allocator calls, failures and the largest free block for each way of
+// holding the JsonBuffer
+
+#include <ArduinoJson.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ArduinoJson;
+
+// First-fit heap with coalescing, like the ESP8266 umm_malloc
+class Heap {
+  struct Header {
+    uint32_t size;                          // with the header
+    uint32_t used;
+  };
+  static const size_t SIZE = 24 * 1024;
+
+ public:
+  Heap() { reset(); }
+
+  void reset() {
+    Header * h = (Header *) _arena;
+    h->size = SIZE;
+    h->used = 0;
+    calls = failures = 0;
+    lowest_largest = SIZE;
+  }
+
+  void * allocate(size_t bytes) {
+    calls++;
+    size_t need = (sizeof(Header) + bytes + 7) & ~(size_t) 7;
+    for (uint8_t * p = _arena; p < _arena + SIZE; p += ((Header *) p)->size) {
+      Header * h = (Header *) p;
+      if (h->used || (h->size < need)) continue;
+      if (h->size - need >= 2 * sizeof(Header)) {
+        Header * rest = (Header *) (p + need);
+        rest->size = h->size - need;
+        rest->used = 0;
+        h->size = need;
+      }
+      h->used = 1;
+      return h + 1;
+    }
+    failures++;
+    return NULL;
+  }
+
+  void deallocate(void * pointer) {
+    if (pointer == NULL) return;
+    calls++;
+    ((Header *) pointer - 1)->used = 0;
+    for (uint8_t * p = _arena; p < _arena + SIZE; p += ((Header *) p)->size) {
+      Header * h = (Header *) p;
+      while (!h->used && (p + h->size < _arena + SIZE) && !((Header *) (p + h->size))->used) {
+        h->size += ((Header *) (p + h->size))->size;
+      }
+    }
+  }
+
+  bool owns(const void * pointer) const {
+    return (pointer >= _arena) && (pointer < _arena + SIZE);
+  }
+
+  size_t largest_free() const {
+    size_t largest = 0;
+    for (const uint8_t * p = _arena; p < _arena + SIZE; p += ((const Header *) p)->size) {
+      const Header * h = (const Header *) p;
+      if (!h->used) largest = std::max(largest, (size_t) h->size - sizeof(Header));
+    }
+    return largest;
+  }
+
+  void sample() { lowest_largest = std::min(lowest_largest, largest_free()); }
+
+  unsigned long calls;
+  unsigned long failures;
+  size_t lowest_largest;
+
+ private:
+  alignas(8) uint8_t _arena[SIZE];
+};
+
+static Heap heap;
+
+class HeapAllocator {
+ public:
+  void * allocate(size_t size) { return heap.allocate(size); }
+  void deallocate(void * pointer) { heap.deallocate(pointer); }
+};
+
+// The pool of THiNXJsonBuffer (THINX_JSON_POOL_BLOCK, THINX_JSON_POOL_BLOCKS),
+// falling back to the heap above instead of malloc()
+template <size_t BLOCK_SIZE, size_t BLOCK_COUNT>
+class HeapPoolAllocator {
+ public:
+  void * allocate(size_t size) {
+    if ((size > BLOCK_SIZE) || (StaticPoolAllocator<BLOCK_SIZE, BLOCK_COUNT>::used() == BLOCK_COUNT)) {
+      return heap.allocate(size);
+    }
+    return _pool.allocate(size);
+  }
+  void deallocate(void * pointer) {
+    if (heap.owns(pointer)) {
+      heap.deallocate(pointer);
+    } else {
+      _pool.deallocate(pointer);
+    }
+  }
+
+ private:
+  StaticPoolAllocator<BLOCK_SIZE, BLOCK_COUNT> _pool;
+};
+
+typedef DynamicJsonBufferBase<HeapAllocator> HeapJsonBuffer;
+typedef DynamicJsonBufferBase<HeapPoolAllocator<384, 4> > PooledJsonBuffer;
+
+enum buffer_mode_t { PER_DOCUMENT, FIXED_BLOCKS, REUSED, POOLED };
+
+static const char * mode_name[] = {"new buffer per document", "fixed 256-byte blocks", "one buffer, clear()",
+                                   "pooled buffer per document"};
+
+static const unsigned long CYCLES = 1000000;
+
+template <typename TBuffer>
+static bool parse(TBuffer & buffer, char * text) {
+  JsonObject & o = buffer.parseObject(text);
+  return o.success();
+}
+
+static void run(buffer_mode_t mode, const std::vector<std::string> & docs) {
+  heap.reset();
+  std::mt19937 random(3);
+  void * application = NULL;
+  HeapJsonBuffer reused;                  // allocates only when used
+  unsigned long parse_failures = 0;
+  std::vector<char> text;
+
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned long k = 0; k < CYCLES; k++) {
+    const std::string & doc = docs[k % docs.size()];
+    text.assign(doc.begin(), doc.end());
+    text.push_back('\0');
+
+    heap.deallocate(application);
+    application = heap.allocate(64 + random() % 448);
+
+    bool ok = false;
+    switch (mode) {
+      case PER_DOCUMENT: {
+        HeapJsonBuffer buffer;
+        ok = parse(buffer, text.data());
+      } break;
+      case FIXED_BLOCKS: {
+        HeapJsonBuffer buffer(256, 1);
+        ok = parse(buffer, text.data());
+      } break;
+      case REUSED:
+        reused.clear();
+        ok = parse(reused, text.data());
+        break;
+      case POOLED: {
+        PooledJsonBuffer buffer(384 - PooledJsonBuffer::blockOverhead, 1);
+        ok = parse(buffer, text.data());
+      } break;
+    }
+    if (!ok) parse_failures++;
+    if ((k & 1023) == 0) heap.sample();
+  }
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / CYCLES;
+
+  heap.deallocate(application);
+  printf("%-28s %5.2f allocator calls/doc, %5.2f us/cycle, %lu heap failures, %lu parse failures, "
+         "largest free block >= %zu bytes\n",
+         mode_name[mode], (heap.calls - 2.0 * CYCLES) / CYCLES, us, heap.failures, parse_failures, heap.lowest_largest);
+}
+
+int main(int argc, char ** argv) {
+  std::string corpus = (argc > 1) ? argv[1] : "corpus";
+  DIR * dir = opendir(corpus.c_str());
+  if (dir == NULL) {
+    printf("no corpus at %s\n", corpus.c_str());
+    return 1;
+  }
+  std::vector<std::string> docs;
+  while (struct dirent * entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if ((name.size() < 5) || (name.compare(name.size() - 5, 5, ".json") != 0)) continue;
+    // Appending walks the list, so its 576-value array would be all we measure
+    if (name == "telemetry.json") continue;
+    std::ifstream file((corpus + "/" + name).c_str(), std::ios::binary);
+    std::stringstream text;
+    text << file.rdbuf();
+    docs.push_back(text.str());
+  }
+  closedir(dir);
+  std::sort(docs.begin(), docs.end());
+
+  run(PER_DOCUMENT, docs);
+  run(FIXED_BLOCKS, docs);
+  run(REUSED, docs);
+  run(POOLED, docs);
+  return 0;
+}
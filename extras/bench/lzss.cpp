@@ -0,0 +1,92 @@
+// Compresses every payload of the corpus (captured THiNX API and MQTT
+// bodies), decodes it back through the streaming decoder and reports the
+// ratio and both throughputs
+
+#include <THiNXLZSS.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+class Sink : public Print {
+  public:
+    size_t write(uint8_t c) { text += (char) c; return 1; }
+    using Print::write;
+    std::string text;
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool run(const std::string & name, const std::string & payload, size_t & in, size_t & out) {
+  const int N = 20000;
+  std::vector<uint8_t> frame(payload.size() + THINX_LZSS_HEADER_SIZE);
+  size_t size = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int k = 0; k < N; k++) {
+    size = THiNXLZSS::compress((const uint8_t *) payload.data(), payload.size(), frame.data(), frame.size());
+  }
+  double compress = payload.size() * (double) N / seconds_since(start) / 1e6;
+  if (size == 0) {
+    printf("%-18s %6zu bytes, does not shrink (sent as is)\n", name.c_str(), payload.size());
+    in += payload.size();
+    out += payload.size();
+    return true;
+  }
+
+  Sink sink;
+  start = std::chrono::steady_clock::now();
+  for (int k = 0; k < N; k++) {
+    sink.text.clear();
+    THiNXLZSSDecoder decoder(sink);
+    decoder.write(frame.data(), size);
+    if (!decoder.done()) {
+      printf("%-18s decoder did not finish\n", name.c_str());
+      return false;
+    }
+  }
+  double decompress = payload.size() * (double) N / seconds_since(start) / 1e6;
+
+  if (sink.text != payload) {
+    printf("%-18s round trip differs\n", name.c_str());
+    return false;
+  }
+  printf("%-18s %6zu -> %5zu bytes (%3.0f%%), compress %6.1f MB/s, decompress %6.1f MB/s\n",
+         name.c_str(), payload.size(), size, 100.0 * size / payload.size(), compress, decompress);
+  in += payload.size();
+  out += size;
+  return true;
+}
+
+int main(int argc, char ** argv) {
+  std::string corpus = (argc > 1) ? argv[1] : "corpus";
+  DIR * dir = opendir(corpus.c_str());
+  if (dir == NULL) {
+    printf("no corpus at %s\n", corpus.c_str());
+    return 1;
+  }
+  std::vector<std::string> names;
+  while (struct dirent * entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if ((name.size() > 5) && (name.compare(name.size() - 5, 5, ".json") == 0)) names.push_back(name);
+  }
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+
+  bool ok = true;
+  size_t in = 0, out = 0;
+  for (size_t i = 0; i < names.size(); i++) {
+    std::ifstream file((corpus + "/" + names[i]).c_str(), std::ios::binary);
+    std::stringstream payload;
+    payload << file.rdbuf();
+    ok = run(names[i], payload.str(), in, out) && ok;
+  }
+  if (in) printf("%-18s %6zu -> %5zu bytes (%3.0f%%)\n", "total", in, out, 100.0 * out / in);
+  return ok ? 0 : 1;
+}
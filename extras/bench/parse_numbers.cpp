@@ -0,0 +1,52 @@
+// Parses a telemetry document (64 readings, 5 fields each) and reads every
+// value, with numbers kept as text and converted by the parser
+
+#include <ArduinoJson.h>
+#include <stdio.h>
+#include <chrono>
+#include <random>
+#include <string>
+
+using namespace ArduinoJson;
+
+static std::string telemetry() {
+  std::mt19937 random(7);
+  std::string doc = "{\"t\":1700000000,\"d\":[";
+  for (int i = 0; i < 64; i++) {
+    char reading[128];
+    snprintf(reading, sizeof(reading), "%s{\"ts\":%d,\"temp\":%.2f,\"hum\":%.1f,\"v\":%.3f,\"rssi\":%d}",
+             i ? "," : "", i * 1000, 15 + (random() % 2000) / 100.0, (random() % 1000) / 10.0,
+             3 + (random() % 1000) / 1000.0, -(int) (random() % 90));
+    doc += reading;
+  }
+  return doc + "]}";
+}
+
+static void run(const std::string & doc, bool convert) {
+  const int N = 20000;
+  double checksum = 0;
+  size_t used = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int k = 0; k < N; k++) {
+    DynamicJsonBuffer buffer(8192);
+    buffer.convertNumbers(convert);
+    JsonObject & o = buffer.parseObject(doc.c_str());
+    JsonArray & readings = o["d"];
+    for (JsonArray::iterator it = readings.begin(); it != readings.end(); ++it) {
+      JsonObject & e = *it;
+      checksum += e["ts"].as<long>() + e["temp"].as<float>() + e["hum"].as<float>() +
+                  e["v"].as<float>() + e["rssi"].as<long>();
+    }
+    used = buffer.size();
+  }
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / N;
+  printf("%-10s doc %zu bytes, buffer %zu bytes, %.1f us/doc (checksum %g)\n",
+         convert ? "converted" : "text", doc.size(), used, us, checksum);
+}
+
+int main() {
+  std::string doc = telemetry();
+  run(doc, false);
+  run(doc, true);
+  return 0;
+}
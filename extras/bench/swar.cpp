@@ -0,0 +1,71 @@
+// Parses and prints a string-heavy document (200 objects of long text
+// fields, a few escapes); built once with ARDUINOJSON_ENABLE_SWAR and once
+// without. Both builds copy and write whole runs, only the scan for the end
+// of a run differs (a word at a time or a byte at a time).
+
+#include <ArduinoJson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace ArduinoJson;
+
+static std::string document() {
+  std::string doc = "[";
+  for (int i = 0; i < 200; i++) {
+    char item[320];
+    snprintf(item, sizeof(item),
+             "%s{\"name\":\"device-%d-living-room-sensor\",\"description\":\"The quick brown fox jumps over the "
+             "lazy dog, firmware build from the nightly channel\",\"path\":\"C:\\\\thinx\\\\firmware\\\\%d\","
+             "\"note\":\"line one\\nline two\"}",
+             i ? "," : "", i, i);
+    doc += item;
+  }
+  return doc + "]";
+}
+
+// Throughput of f over half a second
+template <typename F>
+static double mbps(size_t bytes, F f) {
+  unsigned long runs = 0;
+  double elapsed;
+  auto start = std::chrono::steady_clock::now();
+  do {
+    f();
+    runs++;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  } while (elapsed < 0.5);
+  return bytes * runs / elapsed / 1e6;
+}
+
+int main() {
+  std::string doc = document();
+  std::vector<char> text(doc.size() + 1);
+  DynamicJsonBuffer buffer(65536);
+
+  double in_place = mbps(doc.size(), [&] {
+    memcpy(text.data(), doc.c_str(), doc.size() + 1);
+    buffer.clear();
+    if (!buffer.parseArray(text.data()).success()) abort();
+  });
+  double copied = mbps(doc.size(), [&] {
+    buffer.clear();
+    if (!buffer.parseArray(doc.c_str()).success()) abort();
+  });
+
+  buffer.clear();
+  JsonArray & array = buffer.parseArray(doc.c_str());
+  std::vector<char> out(doc.size() + 16);
+  size_t length = array.printTo(out.data(), out.size());
+  double print = mbps(length, [&] { array.printTo(out.data(), out.size()); });
+  double measure = mbps(length, [&] {
+    if (!array.measureLength()) abort();
+  });
+
+  printf("SWAR %-3s doc %zu bytes: parse in place %4.0f MB/s, parse copy %4.0f MB/s, print %4.0f MB/s, "
+         "measure %4.0f MB/s\n",
+         ARDUINOJSON_ENABLE_SWAR ? "on" : "off", doc.size(), in_place, copied, print, measure);
+  return 0;
+}
@@ -70,6 +70,22 @@
 #define ARDUINOJSON_DEFAULT_NESTING_LIMIT 10
 #endif
 
+// support converting numbers, true and false while parsing instead of keeping
+// their text, for the buffers that ask for it with convertNumbers(true)
+#ifndef ARDUINOJSON_PARSE_NUMBERS
+#define ARDUINOJSON_PARSE_NUMBERS 1
+#endif
+
+// link list nodes with 16-bit distances stored in the JsonVariant padding,
+// the ESP8266 data RAM is small enough for any two nodes to be in reach
+#ifndef ARDUINOJSON_COMPACT_NODES
+#ifdef ESP8266
+#define ARDUINOJSON_COMPACT_NODES 1
+#else
+#define ARDUINOJSON_COMPACT_NODES 0
+#endif
+#endif
+
 #else  // assume this is a computer
 
 // on a computer we have plenty of memory so we can use doubles
@@ -130,6 +146,27 @@
 #define ARDUINOJSON_DEFAULT_NESTING_LIMIT 50
 #endif
 
+// keep the text of numbers, as the unit tests expect
+#ifndef ARDUINOJSON_PARSE_NUMBERS
+#define ARDUINOJSON_PARSE_NUMBERS 0
+#endif
+
+// malloc() may put the blocks of a DynamicJsonBuffer anywhere
+#ifndef ARDUINOJSON_COMPACT_NODES
+#define ARDUINOJSON_COMPACT_NODES 0
+#endif
+
+#endif
+
+// scan strings a machine word at a time instead of byte by byte
+#ifndef ARDUINOJSON_ENABLE_SWAR
+#define ARDUINOJSON_ENABLE_SWAR 1
+#endif
+
+// count allocations, peak usage and failures of every JsonBuffer (stats())
+// changes the layout of JsonBuffer: set it for all translation units at once
+#ifndef ARDUINOJSON_ENABLE_STATS
+#define ARDUINOJSON_ENABLE_STATS 0
 #endif
 
 #if ARDUINOJSON_USE_LONG_LONG && ARDUINOJSON_USE_INT64
@@ -19,7 +19,14 @@ class JsonBufferAllocated {
     return jsonBuffer->alloc(n);
   }
 
+  // type is a JsonBufferStats::Type
+  void *operator new(size_t n, JsonBuffer *jsonBuffer, uint8_t type) throw() {
+    if (!jsonBuffer) return NULL;
+    return jsonBuffer->allocate(n, type);
+  }
+
   void operator delete(void *, JsonBuffer *)throw() {}
+  void operator delete(void *, JsonBuffer *, uint8_t)throw() {}
 };
 }
 }
@@ -0,0 +1,56 @@
+// Copyright Benoit Blanchon 2014-2017
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint8_t
+
+namespace ArduinoJson {
+
+// Usage of a JsonBuffer, kept when ARDUINOJSON_ENABLE_STATS is set.
+// Meant to size buffers from real documents: peak and largest tell how much
+// was needed, the failed* members what did not fit when it did not.
+struct JsonBufferStats {
+  // what an allocation was for
+  enum Type { NONE = 0, ARRAY, OBJECT, NODE, STRING, OTHER };
+
+  size_t peak;          // highest size() seen
+  size_t largest;       // largest document made by a single parse
+  uint32_t allocations;
+  uint32_t failures;
+  uint8_t failedType;   // of the last failure
+  size_t failedSize;    // bytes it asked for
+  size_t failedAt;      // size() when it failed
+
+  void reset() {
+    peak = largest = 0;
+    allocations = failures = 0;
+    failedType = NONE;
+    failedSize = failedAt = 0;
+  }
+
+  // Adds the counters of another buffer, e.g. a short-lived one
+  void merge(const JsonBufferStats &other) {
+    if (other.peak > peak) peak = other.peak;
+    if (other.largest > largest) largest = other.largest;
+    allocations += other.allocations;
+    failures += other.failures;
+    if (other.failures) {
+      failedType = other.failedType;
+      failedSize = other.failedSize;
+      failedAt = other.failedAt;
+    }
+  }
+
+  static const char *typeName(uint8_t type) {
+    static const char *const names[] = {"none", "array", "object",
+                                        "node", "string", "other"};
+    return type <= OTHER ? names[type] : names[NONE];
+  }
+};
+}
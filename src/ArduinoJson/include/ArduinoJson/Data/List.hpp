@@ -44,7 +44,7 @@ class List {
   // For a JsonObject, it would return the number of key-value pairs
   size_t size() const {
     size_t nodeCount = 0;
-    for (node_type *node = _firstNode; node; node = node->next) nodeCount++;
+    for (node_type *node = _firstNode; node; node = node->next()) nodeCount++;
     return nodeCount;
   }
 
@@ -64,12 +64,13 @@ class List {
 
  protected:
   node_type *addNewNode() {
-    node_type *newNode = new (_buffer) node_type();
+    node_type *newNode = new (_buffer, JsonBufferStats::NODE) node_type();
+    if (!newNode) return NULL;
 
     if (_firstNode) {
       node_type *lastNode = _firstNode;
-      while (lastNode->next) lastNode = lastNode->next;
-      lastNode->next = newNode;
+      for (node_type *node; (node = lastNode->next()) != NULL;) lastNode = node;
+      if (!lastNode->setNext(newNode)) return NULL;
     } else {
       _firstNode = newNode;
     }
@@ -80,10 +81,10 @@ class List {
   void removeNode(node_type *nodeToRemove) {
     if (!nodeToRemove) return;
     if (nodeToRemove == _firstNode) {
-      _firstNode = nodeToRemove->next;
+      _firstNode = nodeToRemove->next();
     } else {
-      for (node_type *node = _firstNode; node; node = node->next)
-        if (node->next == nodeToRemove) node->next = nodeToRemove->next;
+      for (node_type *node = _firstNode; node; node = node->next())
+        if (node->next() == nodeToRemove) node->setNext(nodeToRemove->next());
     }
   }
 
@@ -34,7 +34,7 @@ class ListConstIterator {
   }
 
   ListConstIterator<T> &operator++() {
-    if (_node) _node = _node->next;
+    if (_node) _node = _node->next();
     return *this;
   }
 
@@ -35,7 +35,7 @@ class ListIterator {
   }
 
   ListIterator<T> &operator++() {
-    if (_node) _node = _node->next;
+    if (_node) _node = _node->next();
     return *this;
   }
 
@@ -0,0 +1,69 @@
+// Copyright Benoit Blanchon 2014-2017
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include <stddef.h>  // for NULL
+#include <stdint.h>
+
+#include "../Configuration.hpp"
+
+namespace ArduinoJson {
+namespace Internals {
+
+// Link from a list node to the next one, as a signed distance in units of
+// the JsonBuffer alignment: 2 bytes instead of a pointer, small enough to
+// live in the padding at the end of a JsonVariant.
+//
+// It reaches +/-32767 units, +/-128 KB on the ESP8266, which covers its
+// whole data RAM. set() refuses a node further away.
+//
+// The link belongs to the node, not to the value: assigning a JsonVariant,
+// like JsonArray::set() does, never overwrites it. The copy constructor
+// stays trivial so that variants are still passed in registers; nodes are
+// default-constructed, so a link copied into a new variant is never used.
+class ListLink {
+ public:
+  ListLink() : _offset(0) {}
+  ListLink &operator=(const ListLink &) {
+    return *this;
+  }
+
+  template <typename TNode>
+  TNode *get(const TNode *from) const {
+    if (!_offset) return NULL;
+    return reinterpret_cast<TNode *>(const_cast<char *>(
+        reinterpret_cast<const char *>(from) + _offset * unit));
+  }
+
+  template <typename TNode>
+  bool set(const TNode *from, const TNode *to) {
+    if (!to) {
+      _offset = 0;
+      return true;
+    }
+    ptrdiff_t distance =
+        reinterpret_cast<const char *>(to) - reinterpret_cast<const char *>(from);
+    if (distance % unit) return false;
+    distance /= static_cast<ptrdiff_t>(unit);
+    if (distance == 0 || distance < INT16_MIN || distance > INT16_MAX)
+      return false;
+    _offset = static_cast<int16_t>(distance);
+    return true;
+  }
+
+ private:
+#if ARDUINOJSON_ENABLE_ALIGNMENT
+  static const size_t unit = sizeof(void *);
+#else
+  static const size_t unit = 1;
+#endif
+
+  int16_t _offset;
+};
+}
+}
@@ -16,12 +16,40 @@ namespace Internals {
 
 // A node for a singly-linked list.
 // Used by List<T> and its iterators.
+#if ARDUINOJSON_COMPACT_NODES
+// The link hides in the padding of the content, see ListLink.
 template <typename T>
 struct ListNode : public Internals::JsonBufferAllocated {
-  ListNode() : next(NULL) {}
+  ListNode<T> *next() const {
+    return listLink(content).get(this);
+  }
+
+  // Returns false if the node is out of reach
+  bool setNext(ListNode<T> *node) {
+    return listLink(content).set(this, node);
+  }
 
-  ListNode<T> *next;
   T content;
 };
+#else
+template <typename T>
+struct ListNode : public Internals::JsonBufferAllocated {
+  ListNode() : _next(NULL) {}
+
+  ListNode<T> *next() const {
+    return _next;
+  }
+
+  bool setNext(ListNode<T> *node) {
+    _next = node;
+    return true;
+  }
+
+  T content;
+
+ private:
+  ListNode<T> *_next;
+};
+#endif
 }
 }
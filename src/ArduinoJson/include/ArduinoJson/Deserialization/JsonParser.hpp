@@ -9,12 +9,36 @@
 
 #include "../JsonBuffer.hpp"
 #include "../JsonVariant.hpp"
+#include "../Polyfills/parseFloat.hpp"
+#include "../Polyfills/swar.hpp"
+#include "../TypeTraits/IsBaseOf.hpp"
 #include "../TypeTraits/IsConst.hpp"
 #include "StringWriter.hpp"
 
 namespace ArduinoJson {
 namespace Internals {
 
+// Copies the characters of a quoted string up to the next quote or backslash
+// in one go, when the reader is over a string in RAM.
+// Other readers go through JsonParser::parseString() byte by byte.
+template <bool isContiguous>
+struct StringCharsCopier {
+  template <typename TReader, typename TString>
+  static void append(TReader &, TString &, char) {}
+};
+
+template <>
+struct StringCharsCopier<true> {
+  template <typename TReader, typename TString>
+  static void append(TReader &reader, TString &str, char stopChar) {
+    const char *begin = reader.ptr();
+    size_t n = static_cast<size_t>(
+        Polyfills::skipStringChars(begin, stopChar) - begin);
+    str.append(begin, n);
+    reader.skip(n);
+  }
+};
+
 // Parse JSON string to create JsonArrays and JsonObjects
 // This internal class is not indended to be used directly.
 // Instead, use JsonBuffer.parseArray() or .parseObject()
@@ -52,6 +76,10 @@ class JsonParser {
   inline bool parseArrayTo(JsonVariant *destination);
   inline bool parseObjectTo(JsonVariant *destination);
   inline bool parseStringTo(JsonVariant *destination);
+#if ARDUINOJSON_PARSE_NUMBERS
+  inline bool parseLiteralTo(JsonVariant *destination);
+  static inline bool convertLiteral(const char *literal, JsonVariant *destination);
+#endif
 
   static inline bool isInRange(char c, char min, char max) {
     return min <= c && c <= max;
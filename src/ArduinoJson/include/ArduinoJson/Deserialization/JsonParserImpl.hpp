@@ -154,6 +154,9 @@ ArduinoJson::Internals::JsonParser<TReader, TWriter>::parseString() {
     _reader.move();
     char stopChar = c;
     for (;;) {
+      StringCharsCopier<TypeTraits::IsBaseOf<ContiguousReader, TReader>::value>::
+          append(_reader, str, stopChar);
+
       c = _reader.current();
       if (c == '\0') break;
       _reader.move();
@@ -185,6 +188,10 @@ template <typename TReader, typename TWriter>
 inline bool ArduinoJson::Internals::JsonParser<TReader, TWriter>::parseStringTo(
     JsonVariant *destination) {
   bool hasQuotes = isQuote(_reader.current());
+#if ARDUINOJSON_PARSE_NUMBERS
+  if (!hasQuotes && _buffer->convertsNumbers())
+    return parseLiteralTo(destination);
+#endif
   const char *value = parseString();
   if (value == NULL) return false;
   if (hasQuotes) {
@@ -194,3 +201,84 @@ inline bool ArduinoJson::Internals::JsonParser<TReader, TWriter>::parseStringTo(
   }
   return true;
 }
+
+#if ARDUINOJSON_PARSE_NUMBERS
+// Reads an unquoted value into a stack buffer first, so that numbers, true
+// and false are stored as typed values and never take space in the buffer.
+// Anything else (null, identifiers, overlong literals) is kept as raw text.
+template <typename TReader, typename TWriter>
+inline bool
+ArduinoJson::Internals::JsonParser<TReader, TWriter>::parseLiteralTo(
+    JsonVariant *destination) {
+  char literal[32];
+  uint8_t length = 0;
+
+  char c = _reader.current();
+  while (isLetterOrNumber(c) && length < sizeof(literal) - 1) {
+    literal[length++] = c;
+    _reader.move();
+    c = _reader.current();
+  }
+  literal[length] = '\0';
+
+  if (!isLetterOrNumber(c) && convertLiteral(literal, destination))
+    return true;
+
+  typename TypeTraits::RemoveReference<TWriter>::type::String str =
+      _writer.startString();
+  for (uint8_t i = 0; i < length; i++) str.append(literal[i]);
+  while (isLetterOrNumber(c)) {
+    _reader.move();
+    str.append(c);
+    c = _reader.current();
+  }
+
+  const char *value = str.c_str();
+  if (value == NULL) return false;
+  *destination = RawJson(value);
+  return true;
+}
+
+template <typename TReader, typename TWriter>
+inline bool
+ArduinoJson::Internals::JsonParser<TReader, TWriter>::convertLiteral(
+    const char *literal, JsonVariant *destination) {
+  if (!strcmp(literal, "true") || !strcmp(literal, "false")) {
+    *destination = literal[0] == 't';
+    return true;
+  }
+
+  Polyfills::NumberParts number;
+  Polyfills::scanNumber(literal, number);
+  if (!number.complete) return false;
+
+  if (number.integer) {
+    if (!number.negative) {
+      *destination = number.mantissa;
+      return true;
+    }
+    const JsonUInt limit = static_cast<JsonUInt>(~JsonUInt(0) >> 1) + 1;
+    if (number.mantissa < limit) {
+      *destination = static_cast<JsonInteger>(~number.mantissa + 1);
+      return true;
+    }
+  }
+
+  JsonFloat value = Polyfills::makeFloat<JsonFloat>(number, literal);
+
+  // As many decimals as JsonWriter needs to print the literal back
+  JsonFloat magnitude = number.negative ? -value : value;
+  int32_t decimals;
+  if (magnitude != 0 && (magnitude > 1000 || magnitude < 0.001)) {
+    decimals = number.digits - 1;
+  } else {
+    decimals = -number.exponent;
+  }
+  const int32_t maxDecimals = sizeof(JsonFloat) > 4 ? 15 : 7;
+  if (decimals < 0) decimals = 0;
+  if (decimals > maxDecimals) decimals = maxDecimals;
+
+  *destination = JsonVariant(value, static_cast<uint8_t>(decimals));
+  return true;
+}
+#endif
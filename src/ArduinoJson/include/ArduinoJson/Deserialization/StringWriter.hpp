@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <string.h>
+
 namespace ArduinoJson {
 namespace Internals {
 
@@ -21,6 +23,13 @@ class StringWriter {
       *(*_writePtr)++ = c;
     }
 
+    // s is further in the same buffer, or already in place
+    void append(const char* s, size_t n) {
+      TChar* dest = *_writePtr;
+      if (reinterpret_cast<const char*>(dest) != s) memmove(dest, s, n);
+      *_writePtr += n;
+    }
+
     const char* c_str() const {
       *(*_writePtr)++ = 0;
       return reinterpret_cast<const char*>(_startPtr);
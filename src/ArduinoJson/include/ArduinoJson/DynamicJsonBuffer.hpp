@@ -8,6 +8,7 @@
 #pragma once
 
 #include "JsonBufferBase.hpp"
+#include "JsonBufferScope.hpp"
 
 #include <stdlib.h>
 
@@ -46,17 +47,34 @@ class DynamicJsonBufferBase
   };
 
  public:
-  DynamicJsonBufferBase(size_t initialSize = 256)
-      : _head(NULL), _nextBlockCapacity(initialSize) {}
+  // Bytes of each block taken by the buffer itself, e.g. to size blocks so
+  // that they fit a StaticPoolAllocator exactly
+  static const size_t blockOverhead = sizeof(EmptyBlock);
+
+  // initialSize: capacity of the first block
+  // growthFactor: each new block is that many times larger, 1 = fixed size
+  DynamicJsonBufferBase(size_t initialSize = 256, uint8_t growthFactor = 2)
+      : _head(NULL),
+        _spare(NULL),
+        _nextBlockCapacity(initialSize),
+        _growthFactor(growthFactor) {}
 
   ~DynamicJsonBufferBase() {
-    Block* currentBlock = _head;
+    freeBlocks(_head);
+    freeBlocks(_spare);
+  }
 
-    while (currentBlock != NULL) {
-      Block* nextBlock = currentBlock->next;
-      _allocator.deallocate(currentBlock);
-      currentBlock = nextBlock;
-    }
+  // Empties the buffer but keeps its blocks for the next document, so that
+  // a long-lived buffer stops calling the allocator once warmed up.
+  // Everything allocated before becomes invalid.
+  void clear() {
+    while (_head) recycleHead();
+  }
+
+  // Returns the blocks kept by clear() and release() to the allocator
+  void trim() {
+    freeBlocks(_spare);
+    _spare = NULL;
   }
 
   size_t size() const {
@@ -67,7 +85,12 @@ class DynamicJsonBufferBase
 
   virtual void* alloc(size_t bytes) {
     alignNextAlloc();
-    return canAllocInHead(bytes) ? allocInHead(bytes) : allocInNewBlock(bytes);
+    void* p =
+        canAllocInHead(bytes) ? allocInHead(bytes) : allocInNewBlock(bytes);
+#if ARDUINOJSON_ENABLE_STATS
+    this->countAllocation(p, bytes, size());
+#endif
+    return p;
   }
 
   class String {
@@ -90,8 +113,23 @@ class DynamicJsonBufferBase
       _length++;
     }
 
+    void append(const char* s, size_t n) {
+      if (n && _parent->canAllocInHead(n)) {
+        char* end = static_cast<char*>(_parent->allocInHead(n));
+        memcpy(end, s, n);
+        if (_length == 0) _start = end;
+        _length += static_cast<int>(n);
+      } else {
+        while (n--) append(*s++);
+      }
+    }
+
     const char* c_str() {
       append(0);
+#if ARDUINOJSON_ENABLE_STATS
+      _parent->countAllocation(_start, static_cast<size_t>(_length),
+                               _parent->size(), JsonBufferStats::STRING);
+#endif
       return _start;
     }
 
@@ -105,6 +143,28 @@ class DynamicJsonBufferBase
     return String(this);
   }
 
+  // Checkpoint: the head block and its size at the time of mark()
+  struct Checkpoint {
+    Block* head;
+    size_t size;
+    size_t nextBlockCapacity;
+  };
+  typedef JsonBufferScope<DynamicJsonBufferBase> Scope;
+
+  Checkpoint mark() const {
+    Checkpoint checkpoint = {_head, _head ? _head->size : 0,
+                             _nextBlockCapacity};
+    return checkpoint;
+  }
+
+  // Frees everything allocated since the checkpoint. O(1) unless blocks were
+  // added meanwhile, these are kept for reuse (see trim()).
+  void release(const Checkpoint& checkpoint) {
+    while (_head != checkpoint.head && _head != NULL) recycleHead();
+    if (_head && checkpoint.size < _head->size) _head->size = checkpoint.size;
+    _nextBlockCapacity = checkpoint.nextBlockCapacity;
+  }
+
  private:
   void alignNextAlloc() {
     if (_head) _head->size = this->round_size_up(_head->size);
@@ -121,13 +181,43 @@ class DynamicJsonBufferBase
   }
 
   void* allocInNewBlock(size_t bytes) {
+    if (reuseSpareBlock(bytes)) return allocInHead(bytes);
     size_t capacity = _nextBlockCapacity;
     if (bytes > capacity) capacity = bytes;
     if (!addNewBlock(capacity)) return NULL;
-    _nextBlockCapacity *= 2;
+    _nextBlockCapacity *= _growthFactor;
     return allocInHead(bytes);
   }
 
+  // Moves the first spare block large enough for bytes to the head
+  bool reuseSpareBlock(size_t bytes) {
+    for (Block** link = &_spare; *link; link = &(*link)->next) {
+      Block* block = *link;
+      if (block->capacity < bytes) continue;
+      *link = block->next;
+      block->next = _head;
+      _head = block;
+      return true;
+    }
+    return false;
+  }
+
+  void recycleHead() {
+    Block* block = _head;
+    _head = block->next;
+    block->size = 0;
+    block->next = _spare;
+    _spare = block;
+  }
+
+  void freeBlocks(Block* block) {
+    while (block != NULL) {
+      Block* nextBlock = block->next;
+      _allocator.deallocate(block);
+      block = nextBlock;
+    }
+  }
+
   bool addNewBlock(size_t capacity) {
     size_t bytes = sizeof(EmptyBlock) + capacity;
     Block* block = static_cast<Block*>(_allocator.allocate(bytes));
@@ -141,7 +231,9 @@ class DynamicJsonBufferBase
 
   TAllocator _allocator;
   Block* _head;
+  Block* _spare;  // emptied blocks, reused before allocating new ones
   size_t _nextBlockCapacity;
+  uint8_t _growthFactor;
 };
 
 #if defined(__clang__)
@@ -156,4 +248,66 @@ class DynamicJsonBufferBase
 // You are strongly encouraged to consider using StaticJsonBuffer which is much
 // more suitable for embedded systems.
 typedef DynamicJsonBufferBase<DefaultAllocator> DynamicJsonBuffer;
+
+// Allocator drawing fixed-size blocks from a static pool, shared by every
+// buffer using the same BLOCK_SIZE and BLOCK_COUNT. Requests that are too
+// large, or made while the pool is empty, fall back to malloc().
+//
+// typedef DynamicJsonBufferBase<StaticPoolAllocator<512, 4> > PooledBuffer;
+// PooledBuffer buffer(512 - PooledBuffer::blockOverhead, 1);
+template <size_t BLOCK_SIZE, size_t BLOCK_COUNT>
+class StaticPoolAllocator {
+  union Slot {
+    Slot* next;
+    void* align;
+    uint8_t data[BLOCK_SIZE];
+  };
+
+  struct Pool {
+    Slot slots[BLOCK_COUNT];
+    Slot* free;
+    size_t used;
+    bool ready;
+  };
+
+ public:
+  void* allocate(size_t size) {
+    Pool& pool = _pool;
+    if (!pool.ready) {
+      for (size_t i = 0; i < BLOCK_COUNT; i++)
+        pool.slots[i].next = i + 1 < BLOCK_COUNT ? &pool.slots[i + 1] : NULL;
+      pool.free = BLOCK_COUNT ? &pool.slots[0] : NULL;
+      pool.ready = true;
+    }
+    if (size > BLOCK_SIZE || pool.free == NULL) return malloc(size);
+    Slot* slot = pool.free;
+    pool.free = slot->next;
+    pool.used++;
+    return slot;
+  }
+
+  void deallocate(void* pointer) {
+    Pool& pool = _pool;
+    Slot* slot = static_cast<Slot*>(pointer);
+    if (slot < pool.slots || slot >= pool.slots + BLOCK_COUNT) {
+      free(pointer);
+      return;
+    }
+    slot->next = pool.free;
+    pool.free = slot;
+    pool.used--;
+  }
+
+  // Blocks currently handed out from the pool
+  static size_t used() {
+    return _pool.used;
+  }
+
+ private:
+  static Pool _pool;
+};
+
+template <size_t BLOCK_SIZE, size_t BLOCK_COUNT>
+typename StaticPoolAllocator<BLOCK_SIZE, BLOCK_COUNT>::Pool
+    StaticPoolAllocator<BLOCK_SIZE, BLOCK_COUNT>::_pool;
 }
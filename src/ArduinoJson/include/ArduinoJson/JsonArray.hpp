@@ -200,7 +200,7 @@ class JsonArray : public Internals::JsonPrintable<JsonArray>,
  private:
   node_type *findNode(size_t index) const {
     node_type *node = _firstNode;
-    while (node && index--) node = node->next;
+    while (node && index--) node = node->next();
     return node;
   }
 
@@ -11,6 +11,7 @@
 #include <stdint.h>  // for uint8_t
 #include <string.h>
 
+#include "Data/JsonBufferStats.hpp"
 #include "JsonVariant.hpp"
 #include "TypeTraits/EnableIf.hpp"
 #include "TypeTraits/IsArray.hpp"
@@ -75,7 +76,84 @@ class JsonBuffer {
   // Return a pointer to the allocated memory or NULL if allocation fails.
   virtual void *alloc(size_t size) = 0;
 
+  // Same as alloc(), type (a JsonBufferStats::Type) is recorded on failure
+  void *allocate(size_t size, uint8_t type) {
+#if ARDUINOJSON_ENABLE_STATS
+    _allocType = type;
+    void *p = alloc(size);
+    _allocType = JsonBufferStats::OTHER;
+    return p;
+#else
+    (void)type;
+    return alloc(size);
+#endif
+  }
+
+#if ARDUINOJSON_ENABLE_STATS
+  const JsonBufferStats &stats() const {
+    return _stats;
+  }
+
+  void resetStats() {
+    _stats.reset();
+  }
+#endif
+
+#if ARDUINOJSON_PARSE_NUMBERS
+  // Off by default: numbers, true and false are kept as text, as<const char*>()
+  // returns it. When on, the parser stores them as typed values instead.
+  void convertNumbers(bool enable) {
+    _convertNumbers = enable;
+  }
+
+  bool convertsNumbers() const {
+    return _convertNumbers;
+  }
+#endif
+
  protected:
+  JsonBuffer() {
+#if ARDUINOJSON_ENABLE_STATS
+    _allocType = JsonBufferStats::OTHER;
+    _stats.reset();
+#endif
+#if ARDUINOJSON_PARSE_NUMBERS
+    _convertNumbers = false;
+#endif
+  }
+
+#if ARDUINOJSON_ENABLE_STATS
+
+  // Called by the implementations after each allocation: p is NULL when it
+  // failed, used is size() afterwards
+  void countAllocation(const void *p, size_t bytes, size_t used) {
+    countAllocation(p, bytes, used, _allocType);
+  }
+
+  void countAllocation(const void *p, size_t bytes, size_t used,
+                       uint8_t type) {
+    if (p) {
+      _stats.allocations++;
+      if (used > _stats.peak) _stats.peak = used;
+    } else {
+      _stats.failures++;
+      _stats.failedType = type;
+      _stats.failedSize = bytes;
+      _stats.failedAt = used;
+    }
+  }
+
+  void countDocument(size_t bytes) {
+    if (bytes > _stats.largest) _stats.largest = bytes;
+  }
+
+  JsonBufferStats _stats;
+  uint8_t _allocType;  // of the alloc() in progress
+#endif
+#if ARDUINOJSON_PARSE_NUMBERS
+  bool _convertNumbers;
+#endif
+
   // Preserve aligment if necessary
   static FORCE_INLINE size_t round_size_up(size_t bytes) {
 #if ARDUINOJSON_ENABLE_ALIGNMENT
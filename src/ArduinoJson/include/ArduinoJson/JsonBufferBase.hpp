@@ -42,6 +42,7 @@ class JsonBufferBase : public JsonBuffer {
                                 JsonArray &>::type
   parseArray(const TString &json,
              uint8_t nestingLimit = ARDUINOJSON_DEFAULT_NESTING_LIMIT) {
+    ParseCounter counter(that());
     return Internals::makeParser(that(), json, nestingLimit).parseArray();
   }
   //
@@ -50,6 +51,7 @@ class JsonBufferBase : public JsonBuffer {
   template <typename TString>
   JsonArray &parseArray(
       TString *json, uint8_t nestingLimit = ARDUINOJSON_DEFAULT_NESTING_LIMIT) {
+    ParseCounter counter(that());
     return Internals::makeParser(that(), json, nestingLimit).parseArray();
   }
   //
@@ -58,6 +60,7 @@ class JsonBufferBase : public JsonBuffer {
   template <typename TString>
   JsonArray &parseArray(
       TString &json, uint8_t nestingLimit = ARDUINOJSON_DEFAULT_NESTING_LIMIT) {
+    ParseCounter counter(that());
     return Internals::makeParser(that(), json, nestingLimit).parseArray();
   }
 
@@ -79,6 +82,7 @@ class JsonBufferBase : public JsonBuffer {
                                 JsonObject &>::type
   parseObject(const TString &json,
               uint8_t nestingLimit = ARDUINOJSON_DEFAULT_NESTING_LIMIT) {
+    ParseCounter counter(that());
     return Internals::makeParser(that(), json, nestingLimit).parseObject();
   }
   //
@@ -87,6 +91,7 @@ class JsonBufferBase : public JsonBuffer {
   template <typename TString>
   JsonObject &parseObject(
       TString *json, uint8_t nestingLimit = ARDUINOJSON_DEFAULT_NESTING_LIMIT) {
+    ParseCounter counter(that());
     return Internals::makeParser(that(), json, nestingLimit).parseObject();
   }
   //
@@ -95,6 +100,7 @@ class JsonBufferBase : public JsonBuffer {
   template <typename TString>
   JsonObject &parseObject(
       TString &json, uint8_t nestingLimit = ARDUINOJSON_DEFAULT_NESTING_LIMIT) {
+    ParseCounter counter(that());
     return Internals::makeParser(that(), json, nestingLimit).parseObject();
   }
 
@@ -108,6 +114,7 @@ class JsonBufferBase : public JsonBuffer {
                                 JsonVariant>::type
   parse(const TString &json,
         uint8_t nestingLimit = ARDUINOJSON_DEFAULT_NESTING_LIMIT) {
+    ParseCounter counter(that());
     return Internals::makeParser(that(), json, nestingLimit).parseVariant();
   }
   //
@@ -116,6 +123,7 @@ class JsonBufferBase : public JsonBuffer {
   template <typename TString>
   JsonVariant parse(TString *json,
                     uint8_t nestingLimit = ARDUINOJSON_DEFAULT_NESTING_LIMIT) {
+    ParseCounter counter(that());
     return Internals::makeParser(that(), json, nestingLimit).parseVariant();
   }
   //
@@ -124,6 +132,7 @@ class JsonBufferBase : public JsonBuffer {
   template <typename TString>
   JsonVariant parse(TString &json,
                     uint8_t nestingLimit = ARDUINOJSON_DEFAULT_NESTING_LIMIT) {
+    ParseCounter counter(that());
     return Internals::makeParser(that(), json, nestingLimit).parseVariant();
   }
 
@@ -131,6 +140,27 @@ class JsonBufferBase : public JsonBuffer {
   TDerived *that() {
     return static_cast<TDerived *>(this);
   }
+
+  // Records the size of the document made by a parse in stats()
+#if ARDUINOJSON_ENABLE_STATS
+  class ParseCounter {
+   public:
+    explicit ParseCounter(TDerived *buffer)
+        : _buffer(buffer), _start(buffer->size()) {}
+    ~ParseCounter() {
+      size_t end = _buffer->size();
+      _buffer->countDocument(end > _start ? end - _start : 0);
+    }
+
+   private:
+    TDerived *_buffer;
+    size_t _start;
+  };
+#else
+  struct ParseCounter {
+    explicit ParseCounter(TDerived *) {}
+  };
+#endif
 };
 }
 
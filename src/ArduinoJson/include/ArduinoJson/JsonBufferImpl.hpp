@@ -10,11 +10,11 @@
 #include "Deserialization/JsonParser.hpp"
 
 inline ArduinoJson::JsonArray &ArduinoJson::JsonBuffer::createArray() {
-  JsonArray *ptr = new (this) JsonArray(this);
+  JsonArray *ptr = new (this, JsonBufferStats::ARRAY) JsonArray(this);
   return ptr ? *ptr : JsonArray::invalid();
 }
 
 inline ArduinoJson::JsonObject &ArduinoJson::JsonBuffer::createObject() {
-  JsonObject *ptr = new (this) JsonObject(this);
+  JsonObject *ptr = new (this, JsonBufferStats::OBJECT) JsonObject(this);
   return ptr ? *ptr : JsonObject::invalid();
 }
@@ -0,0 +1,40 @@
+// Copyright Benoit Blanchon 2014-2017
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+namespace ArduinoJson {
+
+// Releases everything allocated in a JsonBuffer during its lifetime.
+//
+// TJsonBuffer must provide Checkpoint, mark() and release(Checkpoint).
+// Objects, arrays and strings created inside the scope are invalid after it,
+// scopes on the same buffer must be nested.
+//
+// {
+//   StaticJsonBufferBase::Scope scope(jsonBuffer);
+//   JsonObject& root = jsonBuffer.parseObject(json);
+//   ...
+// } // jsonBuffer is as empty as before
+template <typename TJsonBuffer>
+class JsonBufferScope {
+ public:
+  explicit JsonBufferScope(TJsonBuffer &buffer)
+      : _buffer(buffer), _checkpoint(buffer.mark()) {}
+
+  ~JsonBufferScope() {
+    _buffer.release(_checkpoint);
+  }
+
+ private:
+  JsonBufferScope(const JsonBufferScope &);             // non-copiable
+  JsonBufferScope &operator=(const JsonBufferScope &);  // non-copiable
+
+  TJsonBuffer &_buffer;
+  typename TJsonBuffer::Checkpoint _checkpoint;
+};
+}
@@ -287,7 +287,7 @@ class JsonObject : public Internals::JsonPrintable<JsonObject>,
   // Returns the list node that matches the specified key.
   template <typename TStringRef>
   node_type* findNode(TStringRef key) const {
-    for (node_type* node = _firstNode; node; node = node->next) {
+    for (node_type* node = _firstNode; node; node = node->next()) {
       if (Internals::StringTraits<TStringRef>::equals(key, node->content.key))
         return node;
     }
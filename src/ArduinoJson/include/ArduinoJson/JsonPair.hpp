@@ -16,4 +16,14 @@ struct JsonPair {
   const char* key;
   JsonVariant value;
 };
+
+#if ARDUINOJSON_COMPACT_NODES
+// the key comes first, the node link goes in the padding of the value
+inline Internals::ListLink& listLink(JsonPair& pair) {
+  return listLink(pair.value);
+}
+inline const Internals::ListLink& listLink(const JsonPair& pair) {
+  return listLink(pair.value);
+}
+#endif
 }
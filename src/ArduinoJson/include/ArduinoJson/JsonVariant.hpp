@@ -13,6 +13,7 @@
 #include "Data/JsonVariantContent.hpp"
 #include "Data/JsonVariantDefault.hpp"
 #include "Data/JsonVariantType.hpp"
+#include "Data/ListLink.hpp"
 #include "JsonVariantBase.hpp"
 #include "RawJson.hpp"
 #include "Serialization/JsonPrintable.hpp"
@@ -340,11 +341,23 @@ class JsonVariant : public JsonVariantBase<JsonVariant> {
             !strcmp("null", _content.asString));
   }
 
-  // The current type of the variant
-  Internals::JsonVariantType _type;
-
   // The various alternatives for the value of the variant.
   Internals::JsonVariantContent _content;
+
+  // The current type of the variant, a JsonVariantType in one byte so that
+  // the rest of the padding is free for the link of a list node.
+  uint8_t _type;
+
+#if ARDUINOJSON_COMPACT_NODES
+  Internals::ListLink _link;
+
+  friend Internals::ListLink &listLink(JsonVariant &variant) {
+    return variant._link;
+  }
+  friend const Internals::ListLink &listLink(const JsonVariant &variant) {
+    return variant._link;
+  }
+#endif
 };
 
 inline JsonVariant float_with_n_digits(float value, uint8_t digits) {
@@ -0,0 +1,164 @@
+// Copyright Benoit Blanchon 2014-2017
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "../Data/JsonInteger.hpp"
+#include "parseInteger.hpp"
+
+#include <stdint.h>
+#include <stdlib.h>  // for strtod, strtof
+
+namespace ArduinoJson {
+namespace Polyfills {
+
+// A decimal literal split by scanNumber(): value = mantissa * 10^exponent
+struct NumberParts {
+  Internals::JsonUInt mantissa;  // leading significant digits
+  int32_t exponent;              // includes the position of the decimal point
+  uint8_t digits;                // significant digits in the literal
+  bool negative;
+  bool integer;    // no fraction, no exponent and mantissa did not overflow
+  bool exact;      // mantissa holds every significant digit
+  bool complete;   // the whole string is a number
+};
+
+// Splits a number literal in a single pass, without converting anything.
+inline void scanNumber(const char *s, NumberParts &n) {
+  const Internals::JsonUInt maxMantissa = ~Internals::JsonUInt(0);
+  n.mantissa = 0;
+  n.exponent = 0;
+  n.digits = 0;
+  n.negative = false;
+  n.integer = true;
+  n.exact = true;
+  n.complete = false;
+
+  if (*s == '-') {
+    n.negative = true;
+    s++;
+  } else if (*s == '+') {
+    s++;
+  }
+
+  bool fraction = false;
+  bool any = false;
+  for (;; s++) {
+    char c = *s;
+    if (c == '.' && !fraction) {
+      fraction = true;
+      n.integer = false;
+      continue;
+    }
+    if (!isDigit(c)) break;
+    any = true;
+
+    uint8_t d = static_cast<uint8_t>(c - '0');
+    if (n.mantissa == 0 && d == 0) {  // leading zero, not significant
+      if (fraction) n.exponent--;
+      continue;
+    }
+    if (n.digits < 255) n.digits++;
+
+    if (n.mantissa <= (maxMantissa - d) / 10) {
+      n.mantissa = n.mantissa * 10 + d;
+      if (fraction) n.exponent--;
+    } else {  // beyond precision, only the magnitude matters
+      n.integer = false;
+      n.exact = false;
+      if (!fraction) n.exponent++;
+    }
+  }
+
+  if (any && (*s == 'e' || *s == 'E')) {
+    n.integer = false;
+    s++;
+    bool negativeExponent = false;
+    if (*s == '-') {
+      negativeExponent = true;
+      s++;
+    } else if (*s == '+') {
+      s++;
+    }
+    if (!isDigit(*s)) return;
+    int32_t e = 0;
+    while (isDigit(*s)) {
+      if (e < 10000) e = e * 10 + (*s - '0');
+      s++;
+    }
+    n.exponent += negativeExponent ? -e : e;
+  }
+
+  n.complete = any && *s == '\0';
+}
+
+// 10^e for 0 <= e <= 22, all exactly representable as double
+inline double powerOf10(int32_t e) {
+  static const double powers[] = {1e1, 1e2, 1e4, 1e8, 1e16};
+  double result = 1;
+  for (uint8_t i = 0; e; i++, e >>= 1) {
+    if (e & 1) result *= powers[i];
+  }
+  return result;
+}
+
+// One correctly rounded division or multiplication when both operands are
+// exact (double: mantissa <= 2^53, |exponent| <= 22), strtod() otherwise
+template <typename T>
+T scaleTo(const NumberParts &n, const char *literal) {
+  if (n.exact && static_cast<uint64_t>(n.mantissa) <= (uint64_t(1) << 53) &&
+      n.exponent >= -22 && n.exponent <= 22) {
+    double result = static_cast<double>(n.mantissa);
+    double power = powerOf10(n.exponent < 0 ? -n.exponent : n.exponent);
+    result = n.exponent < 0 ? result / power : result * power;
+    return static_cast<T>(n.negative ? -result : result);
+  }
+  return static_cast<T>(strtod(literal, NULL));
+}
+
+// float has no FPU either, but a single float operation is cheaper than a
+// double one (mantissa <= 2^24, |exponent| <= 10), strtof() otherwise
+template <>
+inline float scaleTo<float>(const NumberParts &n, const char *literal) {
+  if (n.exact && n.mantissa <= 16777216 && n.exponent >= -10 &&
+      n.exponent <= 10) {
+    float result = static_cast<float>(n.mantissa);
+    float power = static_cast<float>(
+        powerOf10(n.exponent < 0 ? -n.exponent : n.exponent));
+    result = n.exponent < 0 ? result / power : result * power;
+    return n.negative ? -result : result;
+  }
+  return strtof(literal, NULL);
+}
+
+// The value of a literal split by scanNumber(), correctly rounded
+template <typename T>
+T makeFloat(const NumberParts &n, const char *literal) {
+  if (!n.mantissa) return n.negative ? -T(0) : T(0);
+  return scaleTo<T>(n, literal);
+}
+
+// Converts a decimal number like strtod(), without it for the common short
+// literals. Also accepts the NaN and Infinity written by JsonWriter.
+template <typename T>
+T parseFloat(const char *s) {
+  if (!s) return 0;
+
+  const char *p = s;
+  if (*p == '-' || *p == '+') p++;
+  if (*p == 'N' || *p == 'I') {
+    T zero = 0;
+    if (*p == 'N') return zero / zero;
+    return *s == '-' ? -1 / zero : 1 / zero;
+  }
+
+  NumberParts n;
+  scanNumber(s, n);
+  return makeFloat<T>(n, s);
+}
+}
+}
@@ -0,0 +1,43 @@
+// Copyright Benoit Blanchon 2014-2017
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "../Data/JsonInteger.hpp"
+
+namespace ArduinoJson {
+namespace Polyfills {
+
+inline bool isDigit(char c) {
+  return '0' <= c && c <= '9';
+}
+
+// Converts a decimal integer, like strtol() but without locale or errno.
+// Accepts an optional sign and stops at the first non-digit.
+template <typename T>
+T parseInteger(const char *s) {
+  if (!s) return 0;
+
+  bool negative = false;
+  if (*s == '-') {
+    negative = true;
+    s++;
+  } else if (*s == '+') {
+    s++;
+  }
+
+  // accumulate unsigned, so that overflow wraps instead of being undefined
+  Internals::JsonUInt result = 0;
+  while (isDigit(*s)) {
+    result = result * 10 + static_cast<Internals::JsonUInt>(*s - '0');
+    s++;
+  }
+
+  return static_cast<T>(negative ? ~result + 1 : result);
+}
+}
+}
@@ -0,0 +1,113 @@
+// Copyright Benoit Blanchon 2014-2017
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "../Configuration.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if ARDUINOJSON_ENABLE_SWAR && (defined(__GNUC__) || defined(__clang__))
+#define ARDUINOJSON_SWAR_WORDS 1
+#else
+#define ARDUINOJSON_SWAR_WORDS 0
+#endif
+
+// the word loads may read a few bytes past the terminator
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define ARDUINOJSON_NO_SANITIZE __attribute__((no_sanitize_address))
+#endif
+#elif defined(__SANITIZE_ADDRESS__)
+#define ARDUINOJSON_NO_SANITIZE __attribute__((no_sanitize_address))
+#endif
+#ifndef ARDUINOJSON_NO_SANITIZE
+#define ARDUINOJSON_NO_SANITIZE
+#endif
+
+namespace ArduinoJson {
+namespace Polyfills {
+
+// "SIMD within a register": tests all the bytes of a machine word at once,
+// 4 on the ESP8266, 8 on a 64-bit computer.
+//
+// Word loads are always aligned, which Xtensa requires and which also works
+// for strings in the memory-mapped flash. The last word may extend past the
+// terminator, but never past the end of the page holding it.
+#if ARDUINOJSON_SWAR_WORDS
+typedef size_t swar_word_t __attribute__((__may_alias__));
+
+inline swar_word_t swarRepeat(uint8_t byte) {
+  return (~swar_word_t(0) / 0xFF) * byte;
+}
+
+// non-zero when at least one byte of x is below n (n <= 0x80)
+inline swar_word_t swarHasLess(swar_word_t x, uint8_t n) {
+  return (x - swarRepeat(n)) & ~x & swarRepeat(0x80);
+}
+
+// non-zero when at least one byte of x equals c
+inline swar_word_t swarHasByte(swar_word_t x, uint8_t c) {
+  return swarHasLess(x ^ swarRepeat(c), 1);
+}
+
+inline bool swarIsAligned(const char *s) {
+  return (reinterpret_cast<uintptr_t>(s) & (sizeof(swar_word_t) - 1)) == 0;
+}
+#endif
+
+inline bool isStringEnd(char c, char quote) {
+  return c == quote || c == '\\' || c == '\0';
+}
+
+inline bool needsEscape(char c) {
+  return c == '\"' || c == '\\' || static_cast<uint8_t>(c) < 0x20;
+}
+
+// Skips the characters of a quoted string that need no processing.
+// Returns a pointer to the first quote, backslash or terminator.
+ARDUINOJSON_NO_SANITIZE
+inline const char *skipStringChars(const char *s, char quote) {
+#if ARDUINOJSON_SWAR_WORDS
+  while (!swarIsAligned(s)) {
+    if (isStringEnd(*s, quote)) return s;
+    s++;
+  }
+  const uint8_t q = static_cast<uint8_t>(quote);
+  for (;;) {
+    swar_word_t w = *reinterpret_cast<const swar_word_t *>(s);
+    if (swarHasLess(w, 1) | swarHasByte(w, q) | swarHasByte(w, '\\')) break;
+    s += sizeof(swar_word_t);
+  }
+#endif
+  while (!isStringEnd(*s, quote)) s++;
+  return s;
+}
+
+// Skips the characters that JsonWriter can copy verbatim.
+// Returns a pointer to the first quote, backslash or control character,
+// which includes the terminator.
+ARDUINOJSON_NO_SANITIZE
+inline const char *skipPlainChars(const char *s) {
+#if ARDUINOJSON_SWAR_WORDS
+  while (!swarIsAligned(s)) {
+    if (needsEscape(*s)) return s;
+    s++;
+  }
+  for (;;) {
+    swar_word_t w = *reinterpret_cast<const swar_word_t *>(s);
+    if (swarHasLess(w, 0x20) | swarHasByte(w, '\"') | swarHasByte(w, '\\'))
+      break;
+    s += sizeof(swar_word_t);
+  }
+#endif
+  while (!needsEscape(*s)) s++;
+  return s;
+}
+}
+}
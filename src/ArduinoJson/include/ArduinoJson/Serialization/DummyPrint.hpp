@@ -18,6 +18,10 @@ class DummyPrint : public Print {
   virtual size_t write(uint8_t) {
     return 1;
   }
+
+  virtual size_t write(const uint8_t *, size_t n) {
+    return n;
+  }
 };
 }
 }
@@ -13,6 +13,7 @@
 #include "../Polyfills/attributes.hpp"
 #include "../Polyfills/math.hpp"
 #include "../Polyfills/normalize.hpp"
+#include "../Polyfills/swar.hpp"
 #include "../Print.hpp"
 
 namespace ArduinoJson {
@@ -66,7 +67,13 @@ class JsonWriter {
       writeRaw("null");
     } else {
       writeRaw('\"');
-      while (*value) writeChar(*value++);
+      for (;;) {
+        const char *special = Polyfills::skipPlainChars(value);
+        writeRaw(value, static_cast<size_t>(special - value));
+        if (!*special) break;
+        writeChar(*special);
+        value = special + 1;
+      }
       writeRaw('\"');
     }
   }
@@ -149,6 +156,9 @@ class JsonWriter {
   void writeRaw(const char *s) {
     _length += _sink.print(s);
   }
+  void writeRaw(const char *s, size_t n) {
+    if (n) _length += _sink.write(reinterpret_cast<const uint8_t *>(s), n);
+  }
   void writeRaw(char c) {
     _length += _sink.write(c);
   }
@@ -9,6 +9,8 @@
 
 #include "../Print.hpp"
 
+#include <string.h>
+
 namespace ArduinoJson {
 namespace Internals {
 
@@ -28,6 +30,14 @@ class StaticStringBuilder : public Print {
     return 1;
   }
 
+  virtual size_t write(const uint8_t *s, size_t n) {
+    if (n > capacity - length) n = capacity - length;
+    memcpy(buffer + length, s, n);
+    length += n;
+    buffer[length] = '\0';
+    return n;
+  }
+
  private:
   char *buffer;
   size_t capacity;
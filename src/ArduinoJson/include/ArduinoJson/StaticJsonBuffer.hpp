@@ -8,6 +8,7 @@
 #pragma once
 
 #include "JsonBufferBase.hpp"
+#include "JsonBufferScope.hpp"
 
 #if defined(__clang__)
 #pragma clang diagnostic push
@@ -36,14 +37,28 @@ class StaticJsonBufferBase : public JsonBufferBase<StaticJsonBufferBase> {
       }
     }
 
+    void append(const char* s, size_t n) {
+      if (_parent->canAlloc(n)) {
+        memcpy(_parent->doAlloc(n), s, n);
+      } else {
+        while (n--) append(*s++);
+      }
+    }
+
     const char* c_str() const {
+      const char* result = NULL;
       if (_parent->canAlloc(1)) {
         char* last = static_cast<char*>(_parent->doAlloc(1));
         *last = '\0';
-        return _start;
-      } else {
-        return NULL;
+        result = _start;
       }
+#if ARDUINOJSON_ENABLE_STATS
+      // the characters that did not fit are lost, this is a lower bound
+      size_t length = static_cast<size_t>(_parent->_buffer + _parent->_size - _start);
+      _parent->countAllocation(result, result ? length : length + 1,
+                               _parent->_size, JsonBufferStats::STRING);
+#endif
+      return result;
     }
 
    private:
@@ -63,14 +78,30 @@ class StaticJsonBufferBase : public JsonBufferBase<StaticJsonBufferBase> {
 
   virtual void* alloc(size_t bytes) {
     alignNextAlloc();
-    if (!canAlloc(bytes)) return NULL;
-    return doAlloc(bytes);
+    void* p = canAlloc(bytes) ? doAlloc(bytes) : NULL;
+#if ARDUINOJSON_ENABLE_STATS
+    countAllocation(p, bytes, _size);
+#endif
+    return p;
   }
 
   String startString() {
     return String(this);
   }
 
+  // Checkpoint: the allocated size at the time of mark()
+  typedef size_t Checkpoint;
+  typedef JsonBufferScope<StaticJsonBufferBase> Scope;
+
+  Checkpoint mark() const {
+    return _size;
+  }
+
+  // Frees everything allocated since the checkpoint, in O(1)
+  void release(Checkpoint checkpoint) {
+    if (checkpoint < _size) _size = checkpoint;
+  }
+
  private:
   void alignNextAlloc() {
     _size = round_size_up(_size);
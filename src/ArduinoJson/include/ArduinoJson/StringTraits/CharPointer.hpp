@@ -13,9 +13,13 @@
 namespace ArduinoJson {
 namespace Internals {
 
+// Tags the readers whose input is a plain string in RAM, which the parser
+// can scan directly with Polyfills::skipStringChars()
+struct ContiguousReader {};
+
 template <typename TChar>
 struct CharPointerTraits {
-  class Reader {
+  class Reader : public ContiguousReader {
     const TChar* _ptr;
 
    public:
@@ -33,6 +37,14 @@ struct CharPointerTraits {
     TChar next() const {
       return _ptr[1];
     }
+
+    const char* ptr() const {
+      return reinterpret_cast<const char*>(_ptr);
+    }
+
+    void skip(size_t n) {
+      _ptr += n;
+    }
   };
 
   static bool equals(const TChar* str, const char* expected) {
@@ -43,7 +55,7 @@ struct CharPointerTraits {
   static char* duplicate(const TChar* str, Buffer* buffer) {
     if (!str) return NULL;
     size_t size = strlen(reinterpret_cast<const char*>(str)) + 1;
-    void* dup = buffer->alloc(size);
+    void* dup = buffer->allocate(size, JsonBufferStats::STRING);
     if (dup != NULL) memcpy(dup, str, size);
     return static_cast<char*>(dup);
   }
@@ -39,7 +39,7 @@ struct StringTraits<const __FlashStringHelper*, void> {
   static char* duplicate(const __FlashStringHelper* str, Buffer* buffer) {
     if (!str) return NULL;
     size_t size = strlen_P((PGM_P)str) + 1;
-    void* dup = buffer->alloc(size);
+    void* dup = buffer->allocate(size, JsonBufferStats::STRING);
     if (dup != NULL) memcpy_P(dup, (PGM_P)str, size);
     return static_cast<char*>(dup);
   }
@@ -24,7 +24,7 @@ struct StdStringTraits {
   static char* duplicate(const TString& str, Buffer* buffer) {
     if (!str.c_str()) return NULL;  // <- Arduino string can return NULL
     size_t size = str.length() + 1;
-    void* dup = buffer->alloc(size);
+    void* dup = buffer->allocate(size, JsonBufferStats::STRING);
     if (dup != NULL) memcpy(dup, str.c_str(), size);
     return static_cast<char*>(dup);
   }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "../Configuration.hpp"
+#include "../Data/JsonBufferStats.hpp"
 
 namespace ArduinoJson {
 namespace Internals {
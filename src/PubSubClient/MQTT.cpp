@@ -393,12 +393,68 @@ namespace MQTT {
   }
 
 
+  // PacketBuffer class
+  PacketBuffer::PacketBuffer(uint16_t topic_length, uint32_t capacity) :
+    _buffer(nullptr),
+    // fixed header with the longest remaining length, topic and packet id
+    _headroom(1 + 4 + 2 + topic_length + 2),
+    _length(0), _capacity(0),
+    _failed(false)
+  {
+    reserve(capacity);
+  }
+
+  PacketBuffer::~PacketBuffer() {
+    if (_buffer != nullptr)
+      delete [] _buffer;
+  }
+
+  bool PacketBuffer::reserve(uint32_t length) {
+    if (_failed)
+      return false;
+    if (_buffer != nullptr && length <= _capacity)
+      return true;
+
+    uint32_t capacity = _capacity ? _capacity : length;
+    while (capacity < length)
+      capacity *= 2;
+
+    uint8_t *buffer = new uint8_t[_headroom + capacity];
+    if (buffer == nullptr) {
+      _failed = true;
+      return false;
+    }
+    if (_buffer != nullptr) {
+      memcpy(buffer + _headroom, _buffer + _headroom, _length);
+      delete [] _buffer;
+    }
+    _buffer = buffer;
+    _capacity = capacity;
+    return true;
+  }
+
+  size_t PacketBuffer::write(uint8_t c) {
+    if (!reserve(_length + 1))
+      return 0;
+    _buffer[_headroom + _length++] = c;
+    return 1;
+  }
+
+  size_t PacketBuffer::write(const uint8_t *data, size_t length) {
+    if (!reserve(_length + length))
+      return 0;
+    memcpy(_buffer + _headroom + _length, data, length);
+    _length += length;
+    return length;
+  }
+
+
   // Publish class
   Publish::Publish(String topic, String payload) :
     Message(PUBLISH),
-    _topic(topic),
+    _topic(topic), _topic_ref({nullptr, 0, nullptr, 0}),
     _payload(nullptr), _payload_len(0),
-    _payload_mine(false)
+    _payload_mine(false), _headroom(0)
   {
     if (payload.length() > 0) {
       _payload = new uint8_t[payload.length()];
@@ -410,10 +466,11 @@ namespace MQTT {
 
   Publish::Publish(String topic, const __FlashStringHelper* payload) :
     Message(PUBLISH),
-    _topic(topic),
-    _payload_len(strlen_P((PGM_P)payload)), _payload(new uint8_t[_payload_len + 1]),
-    _payload_mine(true)
+    _topic(topic), _topic_ref({nullptr, 0, nullptr, 0}),
+    _payload(nullptr), _payload_len(strlen_P((PGM_P)payload)),
+    _payload_mine(true), _headroom(0)
   {
+    _payload = new uint8_t[_payload_len + 1]; // _payload is initialized first
     strncpy_P((char*)_payload, (PGM_P)payload, _payload_len);
   }
 
@@ -425,8 +482,9 @@ namespace MQTT {
 
   Publish::Publish(uint8_t flags, uint8_t* data, uint32_t length) :
     Message(PUBLISH, flags),
+    _topic_ref({nullptr, 0, nullptr, 0}),
     _payload(nullptr), _payload_len(0),
-    _payload_mine(false)
+    _payload_mine(false), _headroom(0)
   {
     uint32_t pos = 0;
     _topic = read<String>(data, pos);
@@ -443,17 +501,45 @@ namespace MQTT {
 
   Publish::Publish(String topic, payload_callback_t pcb, uint32_t length) :
     Message(PUBLISH),
-    _topic(topic),
-    _payload_len(length),
-    _payload(nullptr), _payload_mine(false)
+    _topic(topic), _topic_ref({nullptr, 0, nullptr, 0}),
+    _payload(nullptr), _payload_len(length),
+    _payload_mine(false), _headroom(0)
   {
     _payload_callback = pcb;
   }
 
+  Publish::Publish(String topic, PacketBuffer& payload) :
+    Publish(topic, nullptr, 0, true)
+  {
+    take(payload);
+  }
+
+  Publish::Publish(TopicRef topic, PacketBuffer& payload) :
+    Message(PUBLISH),
+    _topic_ref(topic),
+    _payload(nullptr), _payload_len(0),
+    _payload_mine(true), _headroom(0)
+  {
+    take(payload);
+  }
+
+  void Publish::take(PacketBuffer& buffer) {
+    if (buffer._buffer == nullptr || buffer._failed)
+      return;
+
+    _payload = buffer._buffer + buffer._headroom;
+    _payload_len = buffer._length;
+    _headroom = buffer._headroom;
+    _payload_mine = true;
+    buffer._buffer = nullptr;
+    buffer._length = buffer._capacity = 0;
+  }
+
   Publish::Publish(uint8_t flags, Client& client, uint32_t remaining_length) :
     Message(PUBLISH, flags),
+    _topic_ref({nullptr, 0, nullptr, 0}),
     _payload(nullptr), _payload_len(remaining_length),
-    _payload_mine(false)
+    _payload_mine(false), _headroom(0)
   {
     _stream_client = &client;
 
@@ -472,7 +558,24 @@ namespace MQTT {
 
   Publish::~Publish() {
     if ((_payload_mine) && (_payload != nullptr))
-      delete [] _payload;
+      delete [] (_payload - _headroom);
+  }
+
+  bool Publish::send(Client& client) {
+    uint32_t variable_header_len = variable_header_length();
+    uint32_t remaining_length = variable_header_len + _payload_len;
+    uint32_t header_length = fixed_header_length(remaining_length) + variable_header_len;
+    if ((_payload_callback != nullptr) || (header_length > _headroom))
+      return Message::send(client);
+
+    // Headers go into the room left before the payload
+    uint8_t *packet = _payload - header_length;
+    uint32_t pos = 0;
+    write_fixed_header(packet, pos, remaining_length);
+    write_variable_header(packet, pos);
+
+    uint32_t packet_length = header_length + _payload_len;
+    return client.write(const_cast<const uint8_t*>(packet), packet_length) == packet_length;
   }
 
   Publish& Publish::set_qos(uint8_t q) {
@@ -487,6 +590,20 @@ namespace MQTT {
     return *this;
   }
 
+  String Publish::topic(void) const {
+    if (_topic_ref.name == nullptr)
+      return _topic;
+
+    String str;
+    str.reserve(_topic_ref.length + _topic_ref.suffix_length);
+    for (uint16_t i = 0; i < _topic_ref.length; i++)
+      str += _topic_ref.name[i];
+    for (uint16_t i = 0; i < _topic_ref.suffix_length; i++)
+      str += _topic_ref.suffix[i];
+
+    return str;
+  }
+
   String Publish::payload_string(void) const {
     String str;
     str.reserve(_payload_len);
@@ -497,11 +614,18 @@ namespace MQTT {
   }
 
   uint32_t Publish::variable_header_length(void) const {
-    return 2 + _topic.length() + (qos() ? 2 : 0);
+    uint32_t topic_len = _topic_ref.name ? _topic_ref.length + _topic_ref.suffix_length : _topic.length();
+    return 2 + topic_len + (qos() ? 2 : 0);
   }
 
   void Publish::write_variable_header(uint8_t *buf, uint32_t& bufpos) const {
-    write(buf, bufpos, _topic);
+    if (_topic_ref.name) {
+      write(buf, bufpos, (uint16_t)(_topic_ref.length + _topic_ref.suffix_length));
+      write_bare_payload(buf, bufpos, (uint8_t*)_topic_ref.name, _topic_ref.length);
+      if (_topic_ref.suffix_length)
+        write_bare_payload(buf, bufpos, (uint8_t*)_topic_ref.suffix, _topic_ref.suffix_length);
+    } else
+      write(buf, bufpos, _topic);
     if (qos())
       write_packet_id(buf, bufpos);
   }
@@ -29,6 +29,16 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 // MQTT_KEEPALIVE : keepAlive interval in Seconds
 #define MQTT_KEEPALIVE 15
 
+// Seconds to wait for a response packet (CONNACK, SUBACK, PINGRESP...), capped by keepalive
+#ifndef MQTT_REPLY_TIMEOUT
+#define MQTT_REPLY_TIMEOUT 30
+#endif
+
+// Answered idle pings before an adaptive ping interval is raised
+#ifndef MQTT_PING_STABLE
+#define MQTT_PING_STABLE 3
+#endif
+
 // Packets larger than this can only be streamed
 #ifndef MQTT_TOO_BIG
 #define MQTT_TOO_BIG 4096
@@ -65,6 +75,19 @@ namespace MQTT {
       QOS2 = 2   //! Exactly once
   };
 
+  //! Non-owning reference to a topic name stored elsewhere (e.g. a topic table)
+  /*!
+    The name is sent as two spans, name then suffix, so a shared prefix and a
+    constant suffix need not be joined first. Both must outlive any message
+    constructed from it; suffix may be null.
+  */
+  struct TopicRef {
+    const char *name;
+    uint16_t length;
+    const char *suffix;
+    uint16_t suffix_length;
+  };
+
 #ifdef _GLIBCXX_FUNCTIONAL
   typedef std::function<bool(Client&)> payload_callback_t;
 #else
@@ -146,7 +169,7 @@ namespace MQTT {
 
   public:
     //! Send the message out
-    bool send(Client& client);
+    virtual bool send(Client& client);
 
     //! Get the message type
     message_type type(void) const { return _type; }
@@ -196,6 +219,8 @@ namespace MQTT {
     Connect& set_clean_session(bool cs = true)	{ _clean_session = cs; return *this; }
     //! Unset the "clear session" flag
     Connect& unset_clean_session(void)		{ _clean_session = false; return *this; }
+    //! Get the "clear session" flag
+    bool clean_session(void) const		{ return _clean_session; }
 
     //! Set the "will" flag and associated attributes
     Connect& set_will(String willTopic, String willMessage, uint8_t willQos = 0, bool willRetain = false);
@@ -229,6 +254,55 @@ namespace MQTT {
     ConnectAck(uint8_t* data, uint32_t length);
 
     friend Message* readPacket(Client& client);
+
+  public:
+    //! Did the server keep state from a previous session (clean_session = false)
+    bool session_present(void) const	{ return _session_present; }
+    //! Connect return code, 0 = accepted
+    uint8_t rc(void) const		{ return _rc; }
+  };
+
+
+  //! Growable payload buffer that keeps room for the PUBLISH headers in front
+  /*!
+    Print a payload (e.g. a JSON object) into it and hand it to Publish: the
+    payload is serialized once, and the headers are later written into the room
+    before it, so the packet goes out in one write without another copy.
+  */
+  class PacketBuffer : public Print {
+  public:
+    //! Constructor
+    /*!
+      \param topic_length Length of the topic the payload will be published to
+      \param capacity Initial payload capacity, doubled as needed
+     */
+    PacketBuffer(uint16_t topic_length, uint32_t capacity = 256);
+    ~PacketBuffer();
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *data, size_t length);
+    using Print::write;
+
+    //! Get the payload pointer
+    uint8_t* payload(void) const { return _buffer ? _buffer + _headroom : nullptr; }
+    //! Get the payload length
+    uint32_t length(void) const { return _length; }
+    //! An allocation failed, the payload is incomplete
+    bool failed(void) const { return _failed; }
+
+  private:
+    PacketBuffer(const PacketBuffer&);		// non-copyable
+    PacketBuffer& operator=(const PacketBuffer&);
+
+    bool reserve(uint32_t length);
+
+    uint8_t *_buffer;
+    uint32_t _headroom;
+    uint32_t _length;
+    uint32_t _capacity;
+    bool _failed;
+
+    friend class Publish;
   };
 
 
@@ -236,9 +310,14 @@ namespace MQTT {
   class Publish : public Message {
   protected:
     String _topic;
+    TopicRef _topic_ref;		//! Used instead of _topic when _topic_ref.name is set
     uint8_t *_payload;
     uint32_t _payload_len;
     bool _payload_mine;
+    uint32_t _headroom;		//! Bytes reserved for the headers before an owned _payload
+
+    //! Take over the payload of a PacketBuffer, leaving it empty
+    void take(PacketBuffer& buffer);
 
     uint32_t variable_header_length(void) const;
     void write_variable_header(uint8_t *buf, uint32_t& bufpos) const;
@@ -250,9 +329,9 @@ namespace MQTT {
     //! Private constructor from a payload and allowing _payload_mine to be set
     Publish(String topic, uint8_t* payload, uint32_t length, bool mine) :
       Message(PUBLISH),
-      _topic(topic),
+      _topic(topic), _topic_ref({nullptr, 0, nullptr, 0}),
       _payload(payload), _payload_len(length),
-      _payload_mine(mine)
+      _payload_mine(mine), _headroom(0)
     {}
 
     //! Private constructor from a network buffer
@@ -281,6 +360,33 @@ namespace MQTT {
       Publish(topic, payload, length, false)
     {}
 
+    //! Constructor from a topic reference and arbitrary payload, copies neither
+    /*!
+      \param topic Reference to the topic, must stay valid until sent
+      \param payload Pointer to a block of data
+      \param length The length of the data stored at 'payload'
+     */
+    Publish(TopicRef topic, const uint8_t* payload, uint32_t length) :
+      Message(PUBLISH),
+      _topic_ref(topic),
+      _payload(const_cast<uint8_t*>(payload)), _payload_len(length),
+      _payload_mine(false), _headroom(0)
+    {}
+
+    //! Constructor taking over a payload printed into a PacketBuffer
+    /*!
+      \param topic Topic of this message
+      \param payload Buffer holding the payload, empty afterwards
+     */
+    Publish(String topic, PacketBuffer& payload);
+
+    //! Constructor from a topic reference, taking over a PacketBuffer
+    /*!
+      \param topic Reference to the topic, must stay valid until sent
+      \param payload Buffer holding the payload, empty afterwards
+     */
+    Publish(TopicRef topic, PacketBuffer& payload);
+
     //! Constructor from a callback
     /*!
       \param topic Topic of this message
@@ -296,6 +402,9 @@ namespace MQTT {
 
     ~Publish();
 
+    //! Send the message, in a single write when the headers fit before the payload
+    bool send(Client& client);
+
     //! Get retain flag
     bool retain(void) const		{ return _flags & 0x01; }
     //! Set retain flag
@@ -318,7 +427,7 @@ namespace MQTT {
     Publish& unset_dup(void)		{ _flags = _flags & ~0x08; return *this; }
 
     //! Get the topic string
-    String topic(void) const { return _topic; }
+    String topic(void) const;
 
     //! Get the payload as a string
     String payload_string(void) const;
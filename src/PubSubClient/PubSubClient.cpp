@@ -8,26 +8,44 @@
 PubSubClient::PubSubClient(Client& c) :
   _callback(nullptr),
   _client(c),
+  nextMsgId(0),
   _max_retries(10),
-  isSubAckFound(false)
+  _ping_min(0),
+  _ping_stable(0),
+  _ping(),
+  isSubAckFound(false),
+  _session_present(false),
+  _connack_rc(0)
 {}
 
 PubSubClient::PubSubClient(Client& c, IPAddress &ip, uint16_t port) :
+  server_ip(ip),
+  server_port(port),
   _callback(nullptr),
   _client(c),
+  nextMsgId(0),
   _max_retries(10),
+  _ping_min(0),
+  _ping_stable(0),
+  _ping(),
   isSubAckFound(false),
-  server_ip(ip),
-  server_port(port)
+  _session_present(false),
+  _connack_rc(0)
 {}
 
 PubSubClient::PubSubClient(Client& c, String hostname, uint16_t port) :
+  server_hostname(hostname),
+  server_port(port),
   _callback(nullptr),
   _client(c),
+  nextMsgId(0),
   _max_retries(10),
+  _ping_min(0),
+  _ping_stable(0),
+  _ping(),
   isSubAckFound(false),
-  server_port(port),
-  server_hostname(hostname)
+  _session_present(false),
+  _connack_rc(0)
 {}
 
 PubSubClient& PubSubClient::set_server(IPAddress &ip, uint16_t port) {
@@ -86,14 +104,17 @@ void PubSubClient::_process_message(MQTT::Message* msg) {
     {
       MQTT::Publish *pub = static_cast<MQTT::Publish*>(msg);	// RTTI is disabled on embedded, so no dynamic_cast<>()
 
-      if (_callback)
-	_callback(*pub);
-
+      // Acknowledged first: the callback may restart the device, and an
+      // unacknowledged message is redelivered with every resumed session
       if (pub->qos() == 1) {
 	MQTT::PublishAck puback(pub->packet_id());
 	_send_message(puback);
+      }
 
-      } else if (pub->qos() == 2) {
+      if (_callback)
+	_callback(*pub);
+
+      if (pub->qos() == 2) {
 
 	{
 	  MQTT::PublishRec pubrec(pub->packet_id());
@@ -117,22 +138,83 @@ void PubSubClient::_process_message(MQTT::Message* msg) {
     break;
 
   case MQTT::PINGRESP:
+    if (pingOutstanding)
+      _ping_answered();
     pingOutstanding = false;
   }
 }
 
+void PubSubClient::_ping_answered(void) {
+  _ping.answered++;
+  if (!pingProbe)
+    return;
+
+  if (_ping.interval > _ping.good)
+    _ping.good = _ping.interval;
+
+  if ((_ping_min == 0) || (++_ping_stable < MQTT_PING_STABLE))
+    return;
+  _ping_stable = 0;
+
+  // Grow by half, or halfway towards the interval that failed before
+  uint32_t next = _ping.interval + _ping.interval / 2;
+  if (_ping.ceiling && (next >= _ping.ceiling))
+    next = (_ping.interval + _ping.ceiling) / 2;
+  if (next > keepalive)
+    next = keepalive;
+  if (next > _ping.interval) {
+    _ping.interval = next;
+    _ping.raised++;
+  }
+}
+
+void PubSubClient::_ping_failed(void) {
+  _ping.timeouts++;
+  if ((_ping_min == 0) || !pingProbe)
+    return;
+  _ping_stable = 0;
+
+  // Idle for this long broke the link; fall back to what survived, or halve
+  _ping.ceiling = _ping.interval;
+  uint16_t next = (_ping.good < _ping.interval) ? _ping.good : _ping.interval / 2;
+  if (next < _ping_min)
+    next = _ping_min;
+  if (_ping.good > next)
+    _ping.good = next;
+  if (next < _ping.interval) {
+    _ping.interval = next;
+    _ping.lowered++;
+  }
+}
+
+PubSubClient& PubSubClient::set_adaptive_ping(uint16_t min, uint16_t start) {
+  _ping_min = min;
+  _ping_stable = 0;
+  _ping.interval = start;
+  return *this;
+}
+
 bool PubSubClient::_wait_for(MQTT::message_type match_type, uint16_t match_pid) {
+  // Timed from the request, inbound traffic may have been idle for long
+  unsigned long start = millis();
+  unsigned long timeout = (keepalive < MQTT_REPLY_TIMEOUT ? keepalive : MQTT_REPLY_TIMEOUT) * 1000UL;
+
   while (!_client.available()) {
-    if (millis() - lastInActivity > keepalive * 1000UL)
+    if (millis() - start > timeout)
       return false;
     delay(1);
   }
 
-  while (millis() < lastInActivity + (keepalive * 1000)) {
+  while (millis() - start < timeout) {
     // Read the packet and check it
     MQTT::Message *msg = _recv_message();
     if (msg != nullptr) {
       if (msg->type() == match_type) {
+		if (match_type == MQTT::CONNACK) {
+		  MQTT::ConnectAck *ack = static_cast<MQTT::ConnectAck*>(msg);
+		  _session_present = ack->session_present();
+		  _connack_rc = ack->rc();
+		}
 		uint16_t pid = msg->packet_id();
 		delete msg;
 		if (match_pid)
@@ -190,11 +272,21 @@ bool PubSubClient::connect(MQTT::Connect &conn) {
   }
 
   pingOutstanding = false;
-  nextMsgId = 1;		// Init the next packet id
+  pingSuppressed = millis();
+  if (conn.clean_session() || (nextMsgId == 0))
+    nextMsgId = 1;		// Init the next packet id, a resumed session continues
+  _session_present = false;
+  _connack_rc = 0;
   lastInActivity = millis();	// Init this so that _wait_for() doesn't think we've already timed-out
   keepalive = conn.keepalive();	// Store the keepalive period from this connection
-
-  if (!_send_message(conn, true)) {
+  if ((_ping_min == 0) || (_ping.interval > keepalive))
+    _ping.interval = keepalive;
+  else if (_ping.interval < _ping_min)
+    _ping.interval = _ping_min;
+  if (_ping.ceiling > keepalive)
+    _ping.ceiling = 0;
+
+  if (!_send_message(conn, true) || (_connack_rc != 0)) {
     _client.stop();
     return false;
   }
@@ -207,18 +299,33 @@ bool PubSubClient::loop() {
     return false;
 
   unsigned long t = millis();
-  if ((t - lastInActivity > keepalive * 1000UL) || (t - lastOutActivity > keepalive * 1000UL)) {
-    if (pingOutstanding) {
+  unsigned long interval = _ping.interval * 1000UL;
+  unsigned long idle_in = t - lastInActivity;
+  unsigned long idle_out = t - lastOutActivity;
+
+  if (pingOutstanding) {
+    unsigned long timeout = (keepalive < MQTT_REPLY_TIMEOUT ? keepalive : MQTT_REPLY_TIMEOUT) * 1000UL;
+    if (t - pingSent > timeout) {
+      _ping_failed();
+      pingOutstanding = false;
       _client.stop();
       return false;
-    } else {
-      MQTT::Ping ping;
-      if (!_send_message(ping))
-	return false;
-
-      lastInActivity = lastOutActivity;
-      pingOutstanding = true;
     }
+  } else if (((idle_in > interval) && (idle_out > interval)) || (idle_out > keepalive * 1000UL)) {
+    // Traffic in either direction proves the link, so ping only when both are idle;
+    // the broker however counts only our packets, so never stay silent past keepalive
+    MQTT::Ping ping;
+    pingProbe = (idle_in > interval);
+    if (!_send_message(ping)) {
+      _ping_failed();
+      return false;
+    }
+    _ping.sent++;
+    pingSent = t;
+    pingOutstanding = true;
+  } else if (((idle_in > interval) || (idle_out > interval)) && (t - pingSuppressed > interval)) {
+    pingSuppressed = t;		// a ping on either idle direction would have been sent here
+    _ping.suppressed++;
   }
   if (_client.available()) {
     // Read the packet and check it
@@ -248,6 +355,19 @@ bool PubSubClient::publish(String topic, const uint8_t* payload, uint32_t plengt
   return publish(pub);
 }
 
+bool PubSubClient::publish(MQTT::TopicRef topic, const uint8_t* payload, uint32_t plength, bool retained) {
+  if (!connected())
+    return false;
+
+  MQTT::Publish pub(topic, payload, plength);
+  pub.set_retain(retained);
+  return publish(pub);
+}
+
+bool PubSubClient::publish(MQTT::TopicRef topic, const char* payload, bool retained) {
+  return publish(topic, (const uint8_t*)payload, strlen(payload), retained);
+}
+
 bool PubSubClient::publish(String topic, MQTT::payload_callback_t pcb, uint32_t length, bool retained) {
   if (!connected())
     return false;
@@ -23,6 +23,19 @@ public:
   typedef void(*callback_t)(const MQTT::Publish&);
 #endif
 
+  //! Keepalive ping state and counters, intervals in seconds
+  struct ping_stats_t {
+    uint32_t sent;		//!< PINGREQ packets sent
+    uint32_t answered;		//!< PINGRESP packets received
+    uint32_t suppressed;	//!< intervals where traffic in one direction made a ping unnecessary
+    uint16_t timeouts;		//!< pings lost or unsendable
+    uint16_t raised;		//!< adaptive interval increases
+    uint16_t lowered;		//!< adaptive interval decreases (suspected NAT timeout)
+    uint16_t interval;		//!< idle time before a ping
+    uint16_t good;		//!< longest idle time the link survived
+    uint16_t ceiling;		//!< shortest idle time the link did not survive, 0 = none yet
+  };
+
 private:
    IPAddress server_ip;
    String server_hostname;
@@ -35,7 +48,15 @@ private:
    unsigned long lastOutActivity;
    unsigned long lastInActivity;
    bool pingOutstanding;
+   bool pingProbe;		// ping sent after idle in both directions, its outcome tells about the link
+   unsigned long pingSent;
+   unsigned long pingSuppressed;
+   uint16_t _ping_min;		// 0 = fixed interval (keepalive)
+   uint8_t _ping_stable;
+   ping_stats_t _ping;
    bool isSubAckFound;
+   bool _session_present;
+   uint8_t _connack_rc;
 
    //! Receive a message from the client
    /*!
@@ -53,7 +74,8 @@ private:
    //! Process incoming messages
    /*!
      - Calls the callback function when a PUBLISH message comes in
-     - Handles the handshake for PUBLISH when qos > 0
+     - Handles the handshake for PUBLISH when qos > 0, QoS 1 is acknowledged
+       before the callback runs
      - Handles ping requests and responses
      \param msg Message to process
     */
@@ -68,6 +90,12 @@ private:
     */
    bool _wait_for(MQTT::message_type wait_type, uint16_t wait_pid = 0);
 
+   //! Ping answered, raise an adaptive interval once the link proved stable
+   void _ping_answered(void);
+
+   //! Ping lost, lower an adaptive interval below the idle time that broke the link
+   void _ping_failed(void);
+
    //! Return the next packet id
    uint16_t _next_packet_id(void) {
      nextMsgId++;
@@ -102,6 +130,28 @@ public:
    //! Set the maximum number of retries when waiting for response packets
    PubSubClient& set_max_retries(uint8_t mr) { _max_retries = mr; return *this; }
 
+   //! Did the server resume a previous session on the last connect
+   bool session_present(void) const { return _session_present; }
+   //! Return code of the last CONNACK, 0 = accepted
+   uint8_t connect_rc(void) const { return _connack_rc; }
+
+   //! Get the next packet id, to persist it with a session
+   uint16_t next_packet_id(void) const { return nextMsgId; }
+   //! Continue packet ids of a persisted session (applied when clean_session = false)
+   PubSubClient& set_next_packet_id(uint16_t id) { nextMsgId = id; return *this; }
+
+   //! Adapt the ping interval between min and the connection keepalive
+   /*!
+     The interval rises while idle pings keep getting answered and drops
+     below the idle time after which a ping was lost (e.g. NAT timeout).
+     \param min Lowest interval in seconds, 0 disables adaptation (ping at keepalive)
+     \param start Initial interval in seconds, e.g. a persisted ping_stats().interval
+    */
+   PubSubClient& set_adaptive_ping(uint16_t min, uint16_t start = 0);
+
+   //! Keepalive ping counters and the current interval
+   const ping_stats_t& ping_stats(void) const { return _ping; }
+
    //! Connect to the server with a client id
    /*!
      \param id Client id for this device
@@ -141,6 +191,18 @@ public:
     */
    bool publish(String topic, const uint8_t *payload, uint32_t plength, bool retained = false);
 
+   //! Publish an arbitrary data payload to a referenced topic, without copying either
+   /*!
+     \param topic Reference to a topic name, e.g. from a pre-built topic table
+     \param payload Pointer to contents of the message
+     \param plength Length of the message (pointed to by payload) in bytes
+     \param retained If true, this message will be stored on the server
+    */
+   bool publish(MQTT::TopicRef topic, const uint8_t *payload, uint32_t plength, bool retained = false);
+
+   //! Publish a C string payload to a referenced topic
+   bool publish(MQTT::TopicRef topic, const char *payload, bool retained = false);
+
    //! Publish an arbitrary data payload from a callback
    /*!
      \param topic Topic of this message
@@ -172,7 +234,9 @@ public:
 
    //! Wait for packets to come in, processing them
    /*!
-     Also periodically pings the server
+     Also pings the server, only when the link has been idle in both
+     directions for the ping interval, or when nothing was sent for the
+     whole keepalive (the broker only counts packets from the client)
    */
    bool loop();
 
@@ -48,16 +48,18 @@ namespace MQTT {
   public:
     //! Publish a JSON object from the ArduinoJson library
     /*!
+      The object is serialized once, straight into the packet buffer.
       \param topic Topic of the message
       \param payload Object of the message
     */
     template <typename J>
     PublishJSON(String topic, ArduinoJson::Internals::JsonPrintable<J>& object) :
-      Publish(topic, nullptr, object.measureLength() + 1)
+      Publish(topic, nullptr, 0, true)
     {
-      _payload = new uint8_t[_payload_len];
-      if (_payload != nullptr)
-	object.printTo((char*)_payload, _payload_len);
+      PacketBuffer buffer(topic.length());
+      object.printTo(buffer);
+      buffer.write((uint8_t)0);	// the payload has always carried the terminator
+      take(buffer);
     }
 
   };
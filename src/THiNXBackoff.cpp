@@ -0,0 +1,72 @@
+#include "THiNXBackoff.h"
+
+THiNXBackoff::THiNXBackoff() {
+  configure(1000, 60000, 60);
+  seed(0);
+}
+
+void THiNXBackoff::configure(unsigned long base, unsigned long cap, uint16_t budget) {
+  _base = base;
+  _cap = cap;
+  _budget = budget;
+  _next = 0;
+  _window_start = 0;
+  _window_attempts = 0;
+  _failures = 0;
+  _waiting = false;
+}
+
+void THiNXBackoff::seed(uint32_t seed) {
+  _state = seed ? seed : 0x9E3779B9; // xorshift must not start at zero
+}
+
+bool THiNXBackoff::attempt(unsigned long now) {
+
+  if (_waiting && ((long)(now - _next) < 0)) {
+    return false;
+  }
+
+  if ((now - _window_start >= THINX_BACKOFF_WINDOW) || (_window_attempts == 0)) {
+    _window_start = now;
+    _window_attempts = 0;
+  }
+
+  if (_window_attempts >= _budget) {
+    return false;
+  }
+
+  _window_attempts++;
+  return true;
+}
+
+void THiNXBackoff::failure(unsigned long now) {
+
+  if (_failures < 0xFFFF) {
+    _failures++;
+  }
+
+  unsigned long delay = _base;
+  for (uint16_t i = 1; (i < _failures) && (delay < _cap); i++) {
+    delay <<= 1;
+  }
+  if (delay > _cap) {
+    delay = _cap;
+  }
+
+  // equal jitter: keep half of the delay, randomize the other half
+  unsigned long half = delay / 2;
+  _next = now + half + (next_random() % (half + 1));
+  _waiting = true;
+}
+
+void THiNXBackoff::success() {
+  _failures = 0;
+  _waiting = false;
+}
+
+uint32_t THiNXBackoff::next_random() {
+  _state ^= _state << 13;
+  _state ^= _state >> 17;
+  _state ^= _state << 5;
+  return _state;
+}
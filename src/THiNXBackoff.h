@@ -0,0 +1,59 @@
+#ifndef THiNXBackoff_h
+#define THiNXBackoff_h
+
+#include <Arduino.h>
+
+// Attempt budgets are counted per this window (ms)
+#ifndef THINX_BACKOFF_WINDOW
+#define THINX_BACKOFF_WINDOW 3600000UL
+#endif
+
+//! Capped exponential backoff with per-device jitter, one instance per service
+/*!
+  Never blocks: callers ask attempt() from their loop and report the result
+  with success() or failure(). After n consecutive failures the next attempt
+  is scheduled in [d/2, d] where d = min(cap, base * 2^(n-1)); the random part
+  is seeded per device, so a fleet does not reconnect in lockstep.
+*/
+class THiNXBackoff {
+
+  public:
+
+    THiNXBackoff();
+
+    //! Sets base and maximum delay (ms) and attempts allowed per THINX_BACKOFF_WINDOW
+    void configure(unsigned long base, unsigned long cap, uint16_t budget);
+
+    //! Seeds the jitter generator, use something unique per device and service
+    void seed(uint32_t seed);
+
+    //! True when an attempt may be made now; consumes one attempt from the budget
+    bool attempt(unsigned long now);
+
+    //! Schedules the next attempt after a failed (or lost) connection
+    void failure(unsigned long now);
+
+    //! Resets the delay after a successful attempt
+    void success();
+
+    //! Consecutive failures since last success
+    uint16_t failures() const { return _failures; }
+
+    //! Time of the earliest next attempt (valid after failure())
+    unsigned long next_attempt() const { return _next; }
+
+  private:
+    uint32_t next_random();
+
+    unsigned long _base;
+    unsigned long _cap;
+    unsigned long _next;
+    unsigned long _window_start;
+    uint16_t _budget;
+    uint16_t _window_attempts;
+    uint16_t _failures;
+    bool _waiting;
+    uint32_t _state;                        // xorshift32 state
+};
+
+#endif
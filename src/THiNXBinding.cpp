@@ -0,0 +1,280 @@
+#include "THiNXBinding.h"
+
+using namespace ArduinoJson;
+
+// The scanner below accepts what the server sends: quoted keys, the usual
+// escapes (as unescaped by the JsonParser) and any nesting in skipped values.
+
+static const char * json_space(const char * s) {
+  while ((*s == ' ') || (*s == '\t') || (*s == '\r') || (*s == '\n')) s++;
+  return s;
+}
+
+static bool json_quote(char c) {
+  return (c == '"') || (c == '\'');
+}
+
+static bool json_delimiter(char c) {
+  return (c == '\0') || (c == ',') || (c == ':') || (c == '}') || (c == ']') ||
+         (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n');
+}
+
+// Past the closing quote of the string at s, NULL when unterminated
+static const char * json_skip_string(const char * s) {
+  const char quote = *s++;
+  for (;;) {
+    s = Polyfills::skipStringChars(s, quote);
+    if (*s == quote) return s + 1;
+    if ((*s == '\0') || (s[1] == '\0')) return NULL;
+    s += 2; // escape sequence
+  }
+}
+
+// Past a number, true, false or null
+static const char * json_skip_literal(const char * s) {
+  const char * start = s;
+  while (!json_delimiter(*s)) s++;
+  return (s == start) ? NULL : s;
+}
+
+// Past any value, nested objects and arrays included
+static const char * json_skip_value(const char * s) {
+  if (json_quote(*s)) return json_skip_string(s);
+  if ((*s != '{') && (*s != '[')) return json_skip_literal(s);
+  uint16_t depth = 0; // brackets are counted, not paired
+  do {
+    if (json_quote(*s)) {
+      s = json_skip_string(s);
+      if (s == NULL) return NULL;
+      continue;
+    }
+    if ((*s == '{') || (*s == '[')) {
+      depth++;
+    } else if ((*s == '}') || (*s == ']')) {
+      depth--;
+    } else if (*s == '\0') {
+      return NULL;
+    }
+    s++;
+  } while (depth);
+  return s;
+}
+
+// Enters the object at s: false when it is empty, s is NULL when not an object
+static bool json_enter(const char *& s) {
+  s = json_space(s);
+  if (*s != '{') {
+    s = NULL;
+    return false;
+  }
+  s = json_space(s + 1);
+  if (*s == '}') {
+    s++;
+    return false;
+  }
+  return true;
+}
+
+// Reads "key": and leaves s at the value; the key is not unescaped
+static bool json_key(const char *& s, const char *& key, size_t & length) {
+  if (!json_quote(*s)) return false;
+  const char * end = json_skip_string(s);
+  if (end == NULL) return false;
+  key = s + 1;
+  length = end - key - 1;
+  s = json_space(end);
+  if (*s != ':') return false;
+  s = json_space(s + 1);
+  return true;
+}
+
+// Steps over the separator after a value: true when another member follows,
+// s is NULL on a syntax error
+static bool json_next(const char *& s) {
+  s = json_space(s);
+  if (*s == ',') {
+    s = json_space(s + 1);
+    return true;
+  }
+  s = (*s == '}') ? s + 1 : NULL;
+  return false;
+}
+
+// Value of member name in the object at s, NULL when missing
+static const char * json_member(const char * s, const char * name) {
+  const size_t name_length = strlen(name);
+  if (!json_enter(s)) return NULL;
+  do {
+    const char * key;
+    size_t length;
+    if (!json_key(s, key, length)) return NULL;
+    if ((length == name_length) && (memcmp(key, name, length) == 0)) return s;
+    s = json_skip_value(s);
+    if (s == NULL) return NULL;
+  } while (json_next(s));
+  return NULL;
+}
+
+// Copies a string (unescaped) or a literal (as is) into out[size];
+// truncated is set when the value does not fit, out is empty then
+static const char * json_store_string(const char * s, char * out, uint16_t size, bool & stored, bool & truncated) {
+
+  size_t n = 0;
+
+  if (!json_quote(*s)) {
+    const char * end = json_skip_value(s);
+    if ((end == NULL) || (*s == '{') || (*s == '[') || (strncmp(s, "null", 4) == 0)) {
+      stored = false; // no text to bind
+      out[0] = '\0';
+      return end;
+    }
+    n = end - s;
+    stored = (n < size);
+    truncated = !stored;
+    if (stored) memcpy(out, s, n);
+    out[stored ? n : 0] = '\0';
+    return end;
+  }
+
+  const char quote = *s++;
+  stored = true;
+  for (;;) {
+    const char * run = Polyfills::skipStringChars(s, quote);
+    size_t length = run - s;
+    if (n + length < size) {
+      memcpy(out + n, s, length);
+    } else {
+      stored = false;
+    }
+    n += length;
+    s = run;
+    if (*s == quote) break;
+    if ((*s == '\0') || (s[1] == '\0')) return NULL;
+    if (n + 1 < size) {
+      out[n] = Internals::Encoding::unescapeChar(s[1]);
+    } else {
+      stored = false;
+    }
+    n++;
+    s += 2;
+  }
+  truncated = !stored;
+  out[stored ? n : 0] = '\0';
+  return s + 1;
+}
+
+static const char * json_store(const char * s, const THiNXBinding::field_t & field, uint8_t * base, bool & stored, bool & truncated) {
+
+  void * member = base + field.offset;
+  const char * text = json_quote(*s) ? s + 1 : s;
+
+  switch (field.type) {
+
+    case THiNXBinding::STRING:
+      return json_store_string(s, (char *) member, field.size, stored, truncated);
+
+    case THiNXBinding::INTEGER:
+      *(long *) member = Polyfills::parseInteger<long>(text);
+      break;
+
+    case THiNXBinding::BOOLEAN:
+      if (Polyfills::isDigit(*text) || (*text == '-')) {
+        *(bool *) member = Polyfills::parseInteger<long>(text) != 0;
+      } else {
+        *(bool *) member = (strncmp(text, "true", 4) == 0);
+      }
+      break;
+  }
+
+  stored = true;
+  return json_skip_value(s);
+}
+
+int8_t THiNXBinding::decode(const char * json, const char * envelope, const map_t & map, void * value, uint16_t * truncated) {
+
+  uint8_t * base = (uint8_t *) value;
+  if (truncated != NULL) *truncated = 0;
+  for (uint8_t i = 0; i < map.count; i++) {
+    memset(base + map.fields[i].offset, 0, map.fields[i].size);
+  }
+
+  const char * s = json;
+  if (envelope != NULL) {
+    s = json_member(s, envelope);
+    if (s == NULL) return -1;
+  }
+
+  int8_t count = 0;
+  if (!json_enter(s)) return (s == NULL) ? -1 : 0;
+  do {
+    const char * key;
+    size_t length;
+    if (!json_key(s, key, length)) return -1;
+
+    uint8_t index = 0;
+    const field_t * field = NULL;
+    for (uint8_t i = 0; i < map.count; i++) {
+      const char * name = map.fields[i].key;
+      if ((strncmp(name, key, length) == 0) && (name[length] == '\0')) {
+        field = &map.fields[i];
+        index = i;
+        break;
+      }
+    }
+
+    if (field != NULL) {
+      bool stored = false;
+      bool overflow = false;
+      s = json_store(s, *field, base, stored, overflow);
+      if (stored) count++;
+      if (overflow && (truncated != NULL)) *truncated |= mask(index);
+    } else {
+      s = json_skip_value(s);
+    }
+    if (s == NULL) return -1;
+  } while (json_next(s));
+
+  return (s == NULL) ? -1 : count;
+}
+
+uint16_t THiNXBinding::mask(const map_t & map, const char * key) {
+  for (uint8_t i = 0; i < map.count; i++) {
+    if (strcmp(map.fields[i].key, key) == 0) return mask(i);
+  }
+  return 0;
+}
+
+size_t THiNXBinding::encode(Print & out, const map_t & map, const void * value) {
+
+  const uint8_t * base = (const uint8_t *) value;
+  Internals::JsonWriter writer(out);
+
+  writer.beginObject();
+  for (uint8_t i = 0; i < map.count; i++) {
+    const field_t & field = map.fields[i];
+    const void * member = base + field.offset;
+    if (i) writer.writeComma();
+    writer.writeString(field.key);
+    writer.writeColon();
+    switch (field.type) {
+      case STRING:
+        writer.writeString((const char *) member);
+        break;
+      case INTEGER: {
+        long number = *(const long *) member;
+        Internals::JsonUInt magnitude = (Internals::JsonUInt) number;
+        if (number < 0) {
+          writer.writeRaw('-');
+          magnitude = 0 - magnitude;
+        }
+        writer.writeInteger(magnitude);
+      } break;
+      case BOOLEAN:
+        writer.writeBoolean(*(const bool *) member);
+        break;
+    }
+  }
+  writer.endObject();
+
+  return writer.bytesWritten();
+}
@@ -0,0 +1,135 @@
+#ifndef THiNXBinding_h
+#define THiNXBinding_h
+
+#include <Arduino.h>
+#include <stddef.h>
+
+#include "ArduinoJson/ArduinoJson.h"
+
+//! Binds members of a plain struct to the members of a JSON object
+/*!
+  A struct declares its field map once, next to its definition
+
+    struct thinx_notification_t {
+      char response_type[8];
+      char response[8];
+    };
+
+    THINX_BINDING(thinx_notification_t,
+      THINX_FIELD(thinx_notification_t, response_type),
+      THINX_FIELD(thinx_notification_t, response)
+    );
+
+  and gets a decoder copying values from the JSON text straight into the
+  struct in a single pass (no JsonBuffer, no String temporaries) and an
+  encoder writing the same members back:
+
+    thinx_notification_t n;
+    THiNXBinding::decode(json, "notification", n); // {"notification":{...}}
+    THiNXBinding::encode(out, n);                   // {"response_type":...}
+
+  Member types are checked at compile time. char[N] takes strings and other
+  scalars as text (a value that does not fit leaves the member empty and is
+  reported in the truncated mask), long takes numbers, bool takes true/false.
+  Unknown keys and nested values are skipped, bound members missing from the
+  message read as empty/0/false.
+
+    uint16_t truncated;
+    THiNXBinding::decode(json, "update", update, &truncated);
+    if (truncated & THiNXBinding::mask<thinx_update_t>("url")) { ... }
+*/
+class THiNXBinding {
+
+  public:
+
+    enum field_type {
+      STRING = 0,                           // char[N], always terminated
+      INTEGER,                              // long
+      BOOLEAN                               // bool
+    };
+
+    typedef struct {
+      const char * key;
+      uint16_t offset;                      // of the member in the struct
+      uint16_t size;                        // of the member, with terminator
+      uint8_t type;
+    } field_t;
+
+    typedef struct {
+      const field_t * fields;
+      uint8_t count;
+    } map_t;
+
+    //! Fills the struct from json, or from its member envelope when not NULL
+    /*!
+      Returns the number of members stored, or -1 for malformed JSON and
+      a missing envelope. When truncated is not NULL it receives the mask()
+      bits of members whose value did not fit.
+    */
+    template <typename T>
+    static int8_t decode(const char * json, const char * envelope, T & value, uint16_t * truncated = NULL);
+
+    //! Bit of the member bound to key in a truncated mask, 0 when not bound
+    template <typename T>
+    static uint16_t mask(const char * key);
+
+    //! Writes the bound members as a JSON object, returns the length
+    template <typename T>
+    static size_t encode(Print & out, const T & value);
+
+    // Untyped versions used by the templates above
+    static int8_t decode(const char * json, const char * envelope, const map_t & map, void * value, uint16_t * truncated);
+    static size_t encode(Print & out, const map_t & map, const void * value);
+    static uint16_t mask(const map_t & map, const char * key);
+    static uint16_t mask(uint8_t index) { return (index < 16) ? (1 << index) : 0; }
+};
+
+//! Field map of a struct, defined by THINX_BINDING
+template <typename T> struct THiNXFields;
+
+//! Binding type of a member; left undefined for types that cannot be bound
+template <typename T> struct THiNXFieldType;
+template <size_t N> struct THiNXFieldType<char[N]> {
+  static const uint8_t value = THiNXBinding::STRING;
+};
+template <> struct THiNXFieldType<long> {
+  static const uint8_t value = THiNXBinding::INTEGER;
+};
+template <> struct THiNXFieldType<bool> {
+  static const uint8_t value = THiNXBinding::BOOLEAN;
+};
+
+//! Binds member to the JSON key of the same name
+#define THINX_FIELD(type, member) THINX_FIELD_KEY(type, member, #member)
+
+//! Binds member to another JSON key
+#define THINX_FIELD_KEY(type, member, key) \
+  { key, offsetof(type, member), sizeof(((type *) 0)->member), \
+    THiNXFieldType<decltype(((type *) 0)->member)>::value }
+
+//! Declares the field map of type, the fields are THINX_FIELD()s
+#define THINX_BINDING(type, ...) \
+  template <> struct THiNXFields<type> { \
+    static const THiNXBinding::map_t & map() { \
+      static const THiNXBinding::field_t fields[] = { __VA_ARGS__ }; \
+      static const THiNXBinding::map_t map = { fields, sizeof(fields) / sizeof(fields[0]) }; \
+      return map; \
+    } \
+  }
+
+template <typename T>
+int8_t THiNXBinding::decode(const char * json, const char * envelope, T & value, uint16_t * truncated) {
+  return decode(json, envelope, THiNXFields<T>::map(), &value, truncated);
+}
+
+template <typename T>
+uint16_t THiNXBinding::mask(const char * key) {
+  return mask(THiNXFields<T>::map(), key);
+}
+
+template <typename T>
+size_t THiNXBinding::encode(Print & out, const T & value) {
+  return encode(out, THiNXFields<T>::map(), &value);
+}
+
+#endif
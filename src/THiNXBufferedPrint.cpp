@@ -0,0 +1,40 @@
+#include "THiNXBufferedPrint.h"
+
+THiNXBufferedPrint::THiNXBufferedPrint(Print & sink) :
+  _sink(sink), _length(0), _failed(false) {}
+
+THiNXBufferedPrint::~THiNXBufferedPrint() {
+  flush();
+}
+
+size_t THiNXBufferedPrint::write(uint8_t c) {
+  if (_length == sizeof(_buffer)) flush();
+  if (_failed) return 0;
+  _buffer[_length++] = c;
+  return 1;
+}
+
+size_t THiNXBufferedPrint::write(const uint8_t * data, size_t length) {
+  if (_length + length > sizeof(_buffer)) flush();
+  if (_failed) return 0;
+  if (length >= sizeof(_buffer)) {
+    send(data, length); // large runs skip the copy
+  } else {
+    memcpy(_buffer + _length, data, length);
+    _length += length;
+  }
+  return _failed ? 0 : length;
+}
+
+void THiNXBufferedPrint::flush() {
+  if (_length == 0) return;
+  send(_buffer, _length);
+  _length = 0;
+}
+
+void THiNXBufferedPrint::send(const uint8_t * data, size_t length) {
+  if (_failed) return;
+  if (_sink.write(data, length) != length) {
+    _failed = true;
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef THiNXBufferedPrint_h
+#define THiNXBufferedPrint_h
+
+#include <Arduino.h>
+
+#ifndef THINX_PRINT_BUFFER_SIZE
+#define THINX_PRINT_BUFFER_SIZE 256
+#endif
+
+//! Collects small writes and passes them to a Print sink in chunks
+/*!
+  JsonObject::printTo() emits a token or a few characters at a time; on a
+  WiFiClient every write is a trip into lwIP. Wrapping the client sends the
+  document in THINX_PRINT_BUFFER_SIZE chunks without building it in a String.
+  Whatever is still buffered goes out on flush() or when the adapter leaves scope.
+*/
+class THiNXBufferedPrint : public Print {
+
+  public:
+
+    THiNXBufferedPrint(Print & sink);
+    ~THiNXBufferedPrint();
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t * data, size_t length);
+    using Print::write;
+
+    //! Sends the buffered bytes to the sink
+    void flush();
+
+    //! The sink accepted fewer bytes than offered, later writes are dropped
+    bool failed() const { return _failed; }
+
+  private:
+    THiNXBufferedPrint(const THiNXBufferedPrint &);             // non-copyable
+    THiNXBufferedPrint & operator=(const THiNXBufferedPrint &);
+
+    void send(const uint8_t * data, size_t length);
+
+    Print & _sink;
+    uint8_t _buffer[THINX_PRINT_BUFFER_SIZE];
+    size_t _length;
+    bool _failed;
+};
+
+#endif
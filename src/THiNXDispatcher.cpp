@@ -0,0 +1,134 @@
+#include "THiNXDispatcher.h"
+
+THiNXDispatcher::THiNXDispatcher() {
+  clear();
+}
+
+void THiNXDispatcher::clear() {
+  _node[0].level = 0;
+  _node[0].length = 0;
+  _node[0].handler = -1;
+  _node[0].child = -1;
+  _node[0].sibling = -1;
+  _nodes = 1;
+  _arena_used = 0;
+  _handlers = 0;
+}
+
+// Finds the child of parent with the given level name, optionally creating it
+int16_t THiNXDispatcher::child(int16_t parent, const char * level, uint8_t length, bool create) {
+
+  int16_t last = -1;
+  for (int16_t i = _node[parent].child; i != -1; i = _node[i].sibling) {
+    if ((_node[i].length == length) && (memcmp(_arena + _node[i].level, level, length) == 0)) {
+      return i;
+    }
+    last = i;
+  }
+
+  if (!create) return -1;
+  if (_nodes >= THINX_DISPATCH_NODES) return -1;
+  if (_arena_used + length > THINX_DISPATCH_ARENA) return -1;
+
+  // Reuse an identical level name already in the arena (e.g. "status" under several parents)
+  uint16_t offset = _arena_used;
+  for (uint16_t i = 1; i < _nodes; i++) {
+    if ((_node[i].length == length) && (memcmp(_arena + _node[i].level, level, length) == 0)) {
+      offset = _node[i].level;
+      break;
+    }
+  }
+  if (offset == _arena_used) {
+    memcpy(_arena + _arena_used, level, length);
+    _arena_used += length;
+  }
+
+  int16_t index = _nodes++;
+  node_t & node = _node[index];
+  node.level = offset;
+  node.length = length;
+  node.handler = -1;
+  node.child = -1;
+  node.sibling = -1;
+
+  if (last == -1) {
+    _node[parent].child = index;
+  } else {
+    _node[last].sibling = index;
+  }
+  return index;
+}
+
+bool THiNXDispatcher::add(const char * filter, thinx_handler_t handler, void * context) {
+
+  int16_t node = 0;
+  const char * level = filter;
+
+  while (true) {
+    const char * end = strchr(level, '/');
+    size_t length = end ? (size_t)(end - level) : strlen(level);
+    if (length > 0xFF) return false;
+    node = child(node, level, length, true);
+    if (node == -1) return false;
+    if (end == NULL) break;
+    level = end + 1;
+  }
+
+  if (_node[node].handler == -1) {
+    if (_handlers >= THINX_DISPATCH_HANDLERS) return false;
+    _node[node].handler = _handlers++;
+  }
+  _handler[_node[node].handler].func = handler;
+  _handler[_node[node].handler].context = context;
+  return true;
+}
+
+uint8_t THiNXDispatcher::call(const node_t & node, const char * topic, const uint8_t * payload, size_t length) {
+  if (node.handler == -1) return 0;
+  const route_t & route = _handler[node.handler];
+  route.func(topic, payload, length, route.context);
+  return 1;
+}
+
+uint8_t THiNXDispatcher::match(int16_t parent, const char * level, const char * topic,
+                               const uint8_t * payload, size_t length) {
+
+  const char * end = strchr(level, '/');
+  size_t level_length = end ? (size_t)(end - level) : strlen(level);
+  uint8_t called = 0;
+
+  for (int16_t i = _node[parent].child; i != -1; i = _node[i].sibling) {
+
+    const node_t & node = _node[i];
+
+    if (wildcard(node, '#')) {
+      called += call(node, topic, payload, length);
+      continue;
+    }
+
+    if (!wildcard(node, '+')) {
+      if ((node.length != level_length) || (memcmp(_arena + node.level, level, level_length) != 0)) {
+        continue;
+      }
+    }
+
+    if (end != NULL) {
+      called += match(i, end + 1, topic, payload, length);
+      continue;
+    }
+
+    // Last topic level: this node, and "a/#" also matches "a"
+    called += call(node, topic, payload, length);
+    for (int16_t c = node.child; c != -1; c = _node[c].sibling) {
+      if (wildcard(_node[c], '#')) {
+        called += call(_node[c], topic, payload, length);
+      }
+    }
+  }
+
+  return called;
+}
+
+uint8_t THiNXDispatcher::dispatch(const char * topic, const uint8_t * payload, size_t length) {
+  return match(0, topic, topic, payload, length);
+}
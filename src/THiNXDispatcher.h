@@ -0,0 +1,89 @@
+#ifndef THiNXDispatcher_h
+#define THiNXDispatcher_h
+
+#include <Arduino.h>
+
+// Trie nodes (one per distinct topic level, 8 bytes each)
+#ifndef THINX_DISPATCH_NODES
+#define THINX_DISPATCH_NODES 48
+#endif
+
+// Storage for distinct level names
+#ifndef THINX_DISPATCH_ARENA
+#define THINX_DISPATCH_ARENA 384
+#endif
+
+// Routes (filters with a handler)
+#ifndef THINX_DISPATCH_HANDLERS
+#define THINX_DISPATCH_HANDLERS 16
+#endif
+
+// Limits of the node fields below
+#if (THINX_DISPATCH_NODES > 32767) || (THINX_DISPATCH_ARENA > 65535) || (THINX_DISPATCH_HANDLERS > 127)
+#error "THINX_DISPATCH_NODES, _ARENA or _HANDLERS too large"
+#endif
+
+//! Inbound message handler; payload is not NUL-terminated
+typedef void (*thinx_handler_t)(const char * topic, const uint8_t * payload, size_t length, void * context);
+
+//! Routes inbound PUBLISH messages to handlers by MQTT topic filter
+/*!
+  Filters are split into levels and merged into a trie, so device topics
+  sharing "/owner/udid" are stored once. Dispatch walks the topic level by
+  level, following exact, '+' and '#' children; cost depends on topic depth
+  and siblings per level, not on the number of routes.
+*/
+class THiNXDispatcher {
+
+  public:
+
+    THiNXDispatcher();
+
+    //! Removes all routes, e.g. before topics are rebuilt
+    void clear();
+
+    //! Adds or replaces the handler for a filter, false when out of nodes/arena/handlers
+    bool add(const char * filter, thinx_handler_t handler, void * context = NULL);
+
+    //! Calls every handler whose filter matches; returns how many were called
+    /*!
+      Handlers must not clear() or add() while dispatch() walks the trie,
+      they defer such changes until it returns.
+    */
+    uint8_t dispatch(const char * topic, const uint8_t * payload, size_t length);
+
+    uint8_t routes() const { return _handlers; }
+    uint16_t nodes() const { return _nodes; }
+
+  private:
+
+    typedef struct {
+      uint16_t level;                       // offset of level name in arena
+      uint8_t length;
+      int8_t handler;                       // index into _handler or -1
+      int16_t child;                        // first child or -1
+      int16_t sibling;                      // next sibling or -1
+    } node_t;
+
+    typedef struct {
+      thinx_handler_t func;
+      void * context;
+    } route_t;
+
+    int16_t child(int16_t parent, const char * level, uint8_t length, bool create);
+    bool wildcard(const node_t & node, char c) const {
+      return (node.length == 1) && (_arena[node.level] == c);
+    }
+    uint8_t match(int16_t parent, const char * level, const char * topic,
+                  const uint8_t * payload, size_t length);
+    uint8_t call(const node_t & node, const char * topic, const uint8_t * payload, size_t length);
+
+    node_t _node[THINX_DISPATCH_NODES];     // _node[0] is the root
+    uint16_t _nodes;
+    char _arena[THINX_DISPATCH_ARENA];
+    uint16_t _arena_used;
+    route_t _handler[THINX_DISPATCH_HANDLERS];
+    uint8_t _handlers;
+};
+
+#endif
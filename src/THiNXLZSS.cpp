@@ -0,0 +1,142 @@
+#include "THiNXLZSS.h"
+
+bool THiNXLZSS::is_frame(const uint8_t * data, size_t length) {
+  return (length >= THINX_LZSS_HEADER_SIZE) && (data[0] == 'L') && (data[1] == 'Z');
+}
+
+size_t THiNXLZSS::compress(const uint8_t * input, size_t length, uint8_t * out, size_t capacity) {
+
+  if ((length > 0xFFFF) || (capacity < THINX_LZSS_HEADER_SIZE + 1)) return 0;
+
+  out[0] = 'L';
+  out[1] = 'Z';
+  out[2] = (length >> 8) & 0xFF;
+  out[3] = length & 0xFF;
+
+  size_t pos = 0;
+  size_t outpos = THINX_LZSS_HEADER_SIZE;
+  size_t flag_pos = 0;
+  uint8_t flag_bit = 8;
+
+  while (pos < length) {
+
+    if (flag_bit == 8) {
+      if (outpos >= capacity) return 0;
+      flag_pos = outpos++;
+      out[flag_pos] = 0;
+      flag_bit = 0;
+    }
+
+    // Longest match in the window, the input itself serves as history
+    size_t best_length = 0;
+    size_t best_distance = 0;
+    size_t max_length = length - pos;
+    if (max_length > THINX_LZSS_MAX_MATCH) max_length = THINX_LZSS_MAX_MATCH;
+    size_t start = (pos > THINX_LZSS_WINDOW) ? (pos - THINX_LZSS_WINDOW) : 0;
+
+    if (max_length >= THINX_LZSS_MIN_MATCH) {
+      for (size_t candidate = start; candidate < pos; candidate++) {
+        if (input[candidate] != input[pos]) continue;
+        size_t match = 1;
+        while ((match < max_length) && (input[candidate + match] == input[pos + match])) {
+          match++;
+        }
+        if (match > best_length) {
+          best_length = match;
+          best_distance = pos - candidate;
+          if (match == max_length) break;
+        }
+      }
+    }
+
+    if (best_length >= THINX_LZSS_MIN_MATCH) {
+      if (outpos + 2 > capacity) return 0;
+      out[outpos++] = best_distance - 1;
+      out[outpos++] = best_length - THINX_LZSS_MIN_MATCH;
+      pos += best_length;
+    } else {
+      if (outpos + 1 > capacity) return 0;
+      out[flag_pos] |= (1 << flag_bit);
+      out[outpos++] = input[pos++];
+    }
+    flag_bit++;
+  }
+
+  return (outpos < length) ? outpos : 0;
+}
+
+THiNXLZSSDecoder::THiNXLZSSDecoder(Print & sink) :
+  _sink(sink), _window_pos(0), _state(HEADER), _header_pos(0),
+  _remaining(0), _flags(0), _flag_bits(0), _distance(0)
+{}
+
+void THiNXLZSSDecoder::emit(uint8_t c) {
+  _sink.write(c);
+  _window[_window_pos++] = c;
+  _remaining--;
+}
+
+// Called after each literal or match: pick the state for the next item
+void THiNXLZSSDecoder::next_item() {
+  if (_remaining == 0) {
+    _state = DONE;
+    return;
+  }
+  _flags >>= 1;
+  if (--_flag_bits == 0) {
+    _state = FLAGS;
+  } else {
+    _state = (_flags & 1) ? LITERAL : MATCH_DISTANCE;
+  }
+}
+
+size_t THiNXLZSSDecoder::write(uint8_t c) {
+
+  switch (_state) {
+
+    case HEADER:
+      if ((_header_pos == 0 && c != 'L') || (_header_pos == 1 && c != 'Z')) {
+        _state = FAILED;
+        return 0;
+      }
+      if (_header_pos == 2) _remaining = c << 8;
+      if (_header_pos == 3) {
+        _remaining |= c;
+        _state = (_remaining > 0) ? FLAGS : DONE;
+      }
+      _header_pos++;
+      break;
+
+    case FLAGS:
+      _flags = c;
+      _flag_bits = 8;
+      _state = (_flags & 1) ? LITERAL : MATCH_DISTANCE;
+      break;
+
+    case LITERAL:
+      emit(c);
+      next_item();
+      break;
+
+    case MATCH_DISTANCE:
+      _distance = c;
+      _state = MATCH_LENGTH;
+      break;
+
+    case MATCH_LENGTH: {
+      uint16_t length = c + THINX_LZSS_MIN_MATCH;
+      uint8_t from = _window_pos - _distance - 1; // wraps within the window
+      while (length-- && _remaining) {
+        emit(_window[from++]);
+      }
+      next_item();
+      break;
+    }
+
+    case DONE:
+    case FAILED:
+      return 0;
+  }
+
+  return 1;
+}
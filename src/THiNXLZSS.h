@@ -0,0 +1,71 @@
+#ifndef THiNXLZSS_h
+#define THiNXLZSS_h
+
+#include <Arduino.h>
+
+/*
+ * LZSS frame: 'L' 'Z' <original length, 16 bit big-endian> followed by groups
+ * of one flag byte (LSB first, 1 = literal, 0 = match) and up to 8 items.
+ * A literal is one byte, a match is <distance - 1> <length - 3>, so the
+ * window is 256 bytes and matches run from 3 to 258 bytes.
+ */
+
+#define THINX_LZSS_HEADER_SIZE 4
+#define THINX_LZSS_WINDOW 256
+#define THINX_LZSS_MIN_MATCH 3
+#define THINX_LZSS_MAX_MATCH (THINX_LZSS_MIN_MATCH + 255)
+
+//! Content-Encoding token used in HTTP headers and registration hints
+#define THINX_LZSS_ENCODING "lzss"
+
+class THiNXLZSS {
+
+  public:
+
+    //! True if data starts with an LZSS frame header
+    static bool is_frame(const uint8_t * data, size_t length);
+
+    //! Compresses input into out; returns the frame size, 0 if it would not fit or not shrink
+    static size_t compress(const uint8_t * input, size_t length, uint8_t * out, size_t capacity);
+};
+
+//! Streaming decoder, feeds decompressed bytes to a Print sink (Client, StreamString...)
+/*!
+  Needs only the 256-byte window, so large frames can be decoded straight from
+  the network without holding the compressed or decompressed body in RAM.
+*/
+class THiNXLZSSDecoder : public Print {
+
+  public:
+
+    THiNXLZSSDecoder(Print & sink);
+
+    size_t write(uint8_t c);
+    using Print::write;
+
+    //! All bytes announced in the header were produced
+    bool done() const { return _state == DONE; }
+
+    //! Header mismatch
+    bool failed() const { return _state == FAILED; }
+
+  private:
+    void emit(uint8_t c);
+    void next_item();
+
+    enum state_t {
+      HEADER, FLAGS, LITERAL, MATCH_DISTANCE, MATCH_LENGTH, DONE, FAILED
+    };
+
+    Print & _sink;
+    uint8_t _window[THINX_LZSS_WINDOW];
+    uint8_t _window_pos;                    // wraps at 256
+    state_t _state;
+    uint8_t _header_pos;
+    uint16_t _remaining;                    // decompressed bytes still expected
+    uint8_t _flags;
+    uint8_t _flag_bits;                     // items left in the current group
+    uint8_t _distance;
+};
+
+#endif
@@ -1,5 +1,7 @@
 #include "THiNXLib.h"
 
+#include <new>
+
 #ifndef UNIT_TEST  // IMPORTANT LINE!
 
 extern "C" {
@@ -9,12 +11,35 @@ extern "C" {
   extern cont_t g_cont;
 }
 
+// Defaults for thinx.h files generated before check-in scheduling existed
+#ifndef THINX_CHECKIN_SPREAD
+#define THINX_CHECKIN_SPREAD 60
+#endif
+
+#ifndef THINX_CHECKIN_INTERVAL
+#define THINX_CHECKIN_INTERVAL 3600
+#endif
+
 register uint32_t *sp asm("a1");
 
 THiNX::THiNX() {
 }
 
 THiNX::THiNX(const char * __apikey) {
+  init(__apikey);
+}
+
+// Kept for sketches written as `thx = THiNX(apikey);`. Callbacks are bound to
+// the temporary, so nothing is copied: this object is initialized in its place.
+THiNX & THiNX::operator=(const THiNX & other) {
+  if (this != &other) {
+    init(other.thinx_api_key);
+  }
+  return *this;
+}
+
+// Construct the global THiNX object empty, then init() it from setup()
+void THiNX::init(const char * __apikey) {
 
   Serial.print(String("\nTHiNXLib rev. "));
   Serial.print(String(THX_REVISION));
@@ -23,6 +48,11 @@ THiNX::THiNX(const char * __apikey) {
   wdt_disable(); // causes wdt reset after 8 seconds!
   wdt_enable(16384); // must be called from wdt_disable() state!
 
+#if ARDUINOJSON_PARSE_NUMBERS
+  // THiNX messages read numbers as numbers, application buffers keep the text
+  jsonBuffer.convertNumbers(true);
+#endif
+
   status = WL_IDLE_STATUS;
   once = true;
   should_save_config = false;
@@ -35,6 +65,7 @@ THiNX::THiNX(const char * __apikey) {
   }
 
   checked_in = false;
+  all_done = false;
   mqtt_payload = "";
   mqtt_result = false;
   mqtt_connected = false;
@@ -43,6 +74,11 @@ THiNX::THiNX(const char * __apikey) {
   wifi_connection_in_progress = false;
   thx_wifi_client = new WiFiClient();
 
+#ifdef __USE_WIFI_FAST_CONNECT__
+  wifi_fast_connect_in_progress = false;
+  wifi_fast_connect_start = 0;
+#endif
+
   thinx_udid = strdup(THINX_UDID);
   app_version = strdup("");
   available_update_url = strdup("");
@@ -57,6 +93,46 @@ THiNX::THiNX(const char * __apikey) {
 
   wifi_retry = 0;
 
+  duty_cycle_seconds = 0;
+  duty_cycle_frame_sent = false;
+  duty_cycle_listen_start = 0;
+  session_wake_count = 0;
+
+  wifi_wait_start = 0;
+  wifi_wait_timeout = THINX_WIFI_CONNECT_TIMEOUT;
+
+  // Each service backs off independently, jitter differs per device and service
+  wifi_backoff.configure(THINX_BACKOFF_WIFI);
+  wifi_backoff.seed(ESP.getChipId() ^ 0x57494649);
+  api_backoff.configure(THINX_BACKOFF_API);
+  api_backoff.seed(ESP.getChipId() ^ 0x41504921);
+  mqtt_backoff.configure(THINX_BACKOFF_MQTT);
+  mqtt_backoff.seed(ESP.getChipId() ^ 0x4D515454);
+
+  checkin_interval = THINX_CHECKIN_INTERVAL;
+  checkin_slot = 0;
+  checkin_hash = 0;
+  checkin_hash_acked = 0;
+  checkin_conditional = false;
+  checkin_schedule_initial();
+  mqtt_compress = false;
+  commands_count = 0;
+  update_approved = false;
+  shadow_last_scan = 0;
+  mqtt_subscribed = 0;
+  mqtt_clean_session = false;
+  identity_pending = false;
+  mqtt_packet_id = 0;
+  mqtt_ping_interval = THINX_MQTT_PING_MIN;
+  rpc_methods();
+#ifdef __USE_SPIFFS__
+  telemetry.setSpill(telemetry_spill);
+  telemetry_clock_restore();
+#endif
+#ifdef __USE_MSGPACK__
+  checkin_msgpack = true;
+#endif
+
 #ifdef __USE_WIFI_MANAGER__
   manager = new WiFiManager;
   api_key_param = new WiFiManagerParameter("apikey", "API Key", thinx_api_key, 64);
@@ -99,12 +175,15 @@ THiNX::THiNX(const char * __apikey) {
   if ((WiFi.status() == WL_CONNECTED) && (WiFi.getMode() == WIFI_STA)) {
     connected = true;
     wifi_connection_in_progress = false;
+#ifdef __USE_WIFI_FAST_CONNECT__
+    wifi_cache_store();
+#endif
   } else {
     WiFi.mode(WIFI_STA);
   }
 #endif
 
-  EEPROM.begin(512); // should be SPI_FLASH_SEC_SIZE
+  EEPROM.begin(THINX_EEPROM_INFO_SIZE + THINX_SHADOW_EEPROM_SIZE); // should be SPI_FLASH_SEC_SIZE
   import_build_time_constants();
 
   Serial.print(" (");
@@ -134,8 +213,18 @@ void THiNX::initWithAPIKey(const char * __apikey) {
 
   Serial.println("*TH: initWithAPIKey...");
 
+  if (session_restore()) {
+    Serial.println("*TH: Session restored from RTC memory.");
+    checked_in = true; // registration is still valid, skip API check-in
+    checkin_pending = false;
+    shadow_begin();
+    update_topics();
+    return;
+  }
+
   // may cause LoadStoreError(3)
   restore_device_info();
+  shadow_begin(); // newer per-field values override the device info
 
   Serial.println("*TH: Device info restored.");
 
@@ -153,6 +242,8 @@ void THiNX::initWithAPIKey(const char * __apikey) {
       thinx_api_key = strdup(__apikey);
     }
   }
+
+  update_topics();
 }
 
 void THiNX::connect() {
@@ -182,7 +273,13 @@ void THiNX::connect() {
         ETS_UART_INTR_ENABLE();
         Serial.println("*TH: LOOP > CONNECT > STA RECONNECT");
         //WiFi.begin(THINX_ENV_SSID, THINX_ENV_PASS);
+#ifdef __USE_WIFI_FAST_CONNECT__
+        if (!wifi_fast_connect(WiFi.SSID().c_str(), WiFi.psk().c_str())) {
+          WiFi.begin();
+        }
+#else
         WiFi.begin();
+#endif
       }
 
       wifi_connection_in_progress = true; // prevents re-entering connect_wifi(); should timeout
@@ -265,7 +362,13 @@ void THiNX::connect_wifi() {
       if (wifi_retry == 0) {
         Serial.println("*TH: Connecting to AP with pre-defined credentials...");
         WiFi.mode(WIFI_STA);
+#ifdef __USE_WIFI_FAST_CONNECT__
+        if (!wifi_fast_connect(THINX_ENV_SSID, THINX_ENV_PASS)) {
+          WiFi.begin(THINX_ENV_SSID, THINX_ENV_PASS);
+        }
+#else
         WiFi.begin(THINX_ENV_SSID, THINX_ENV_PASS);
+#endif
         wifi_connection_in_progress = true; // prevents re-entering connect_wifi()
       }
     }
@@ -273,23 +376,182 @@ void THiNX::connect_wifi() {
 #endif
  }
 
- void THiNX::checkin() {
+/*
+ * WiFi Fast Connect
+ */
+
+// Plain bitwise CRC32 (IEEE), used to validate RTC memory contents
+uint32_t THiNX::crc32(const void * data, size_t length, uint32_t seed) {
+  const uint8_t * bytes = (const uint8_t *) data;
+  uint32_t crc = ~seed;
+  while (length--) {
+    crc ^= *bytes++;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+#ifdef __USE_WIFI_FAST_CONNECT__
+
+// Directed connect to the last good BSSID/channel with the last IP lease,
+// skipping both the scan and DHCP. Returns false when there is no usable cache.
+bool THiNX::wifi_fast_connect(const char * ssid, const char * pass) {
+
+  if (strlen(ssid) == 0) return false;
+
+  thinx_wifi_cache_t cache;
+  if (!ESP.rtcUserMemoryRead(THINX_RTC_WIFI_CACHE, (uint32_t*) &cache, sizeof(cache))) {
+    return false;
+  }
+
+  if (cache.crc != crc32(&cache.ssid_crc, sizeof(cache) - sizeof(cache.crc))) {
+    Serial.println("*TH: No fast connect cache.");
+    return false;
+  }
+
+  if (cache.ssid_crc != crc32(ssid, strlen(ssid))) {
+    Serial.println("*TH: Fast connect cache belongs to another network.");
+    return false;
+  }
+
+  Serial.print("*TH: Fast connect on channel "); Serial.println(cache.channel);
+
+  WiFi.mode(WIFI_STA);
+  WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.netmask), IPAddress(cache.dns));
+  bool persistent = WiFi.getPersistent(); // the application's choice, restored below
+  WiFi.persistent(false); // do not rewrite SDK config in flash on every boot
+  WiFi.begin(ssid, pass, cache.channel, cache.bssid, true);
+  WiFi.persistent(persistent);
+
+  wifi_fast_connect_in_progress = true;
+  wifi_fast_connect_start = millis();
+  return true;
+}
+
+// Called from loop while not connected; falls back to the full scan/DHCP path
+void THiNX::wifi_fast_connect_check() {
+
+  if (!wifi_fast_connect_in_progress) return;
+  if (millis() - wifi_fast_connect_start < THINX_FAST_CONNECT_TIMEOUT) return;
+
+  Serial.println("*TH: Fast connect timed out, falling back to DHCP...");
+  wifi_fast_connect_in_progress = false;
+  wifi_cache_invalidate();
+
+  IPAddress none(0, 0, 0, 0);
+  WiFi.config(none, none, none); // re-enables DHCP client
+  String ssid = WiFi.SSID();
+  String pass = WiFi.psk();
+  WiFi.begin(ssid.c_str(), pass.c_str()); // without BSSID lock
+}
+
+void THiNX::wifi_cache_store() {
+
+  thinx_wifi_cache_t cache;
+  memset(&cache, 0, sizeof(cache));
+
+  String ssid = WiFi.SSID();
+  cache.ssid_crc = crc32(ssid.c_str(), ssid.length());
+  cache.ip = (uint32_t) WiFi.localIP();
+  cache.gateway = (uint32_t) WiFi.gatewayIP();
+  cache.netmask = (uint32_t) WiFi.subnetMask();
+  cache.dns = (uint32_t) WiFi.dnsIP(0);
+  memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+  cache.channel = WiFi.channel();
+  cache.crc = crc32(&cache.ssid_crc, sizeof(cache) - sizeof(cache.crc));
+
+  ESP.rtcUserMemoryWrite(THINX_RTC_WIFI_CACHE, (uint32_t*) &cache, sizeof(cache));
+}
+
+void THiNX::wifi_cache_invalidate() {
+  thinx_wifi_cache_t cache;
+  memset(&cache, 0, sizeof(cache));
+  ESP.rtcUserMemoryWrite(THINX_RTC_WIFI_CACHE, (uint32_t*) &cache, sizeof(cache));
+}
+
+#endif
+
+ bool THiNX::checkin() {
    Serial.println("*TH: Starting API checkin...");
    if(!connected) {
      Serial.println("*TH: Cannot checkin while not connected, exiting.");
-   } else {
-     senddata(checkin_body());
+     return false;
+   }
+#ifdef __USE_MSGPACK__
+   if (checkin_msgpack) {
+     StaticJsonBufferBase::Scope scope(jsonBuffer);
+     THiNXMsgPack packer(buf, sizeof(buf));
+     packer.value(checkin_object());
+     if (!packer.overflowed()) {
+       return senddata(buf, packer.size(), "application/msgpack");
+     }
+     Serial.println("*TH: MessagePack body too large, sending JSON.");
+   }
+#endif
+   {
+     StaticJsonBufferBase::Scope scope(jsonBuffer);
+     JsonObject& body = checkin_object();
+     size_t length = body.measureLength();
+     if (!api_request(length, "application/json")) return false;
+     THiNXBufferedPrint out(*thx_wifi_client); // straight to the socket, no String copy
+     size_t written = body.printTo(out);
+     out.flush();
+     if (out.failed() || (written != length)) {
+       Serial.println("*TH: Checkin body does not match its Content-Length, request dropped.");
+       thx_wifi_client->stop();
+       return false;
+     }
+   } // request tree released before the reply is parsed into jsonBuffer
+   return api_response();
+ }
+
+ // CRC32 over everything the full registration body carries
+ uint32_t THiNX::registration_hash() {
+   const char * fields[] = {
+     thinx_mac(), THINX_FIRMWARE_VERSION, THINX_FIRMWARE_VERSION_SHORT, THINX_COMMIT_ID,
+     thinx_owner, thinx_alias, thinx_udid, THINX_PLATFORM
+   };
+   uint32_t hash = 0;
+   for (uint8_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+     hash = crc32(fields[i], strlen(fields[i]) + 1, hash); // incl. terminator as separator
    }
+   return hash;
  }
 
  String THiNX::checkin_body() {
+   StaticJsonBufferBase::Scope scope(jsonBuffer);
+   String body;
+   checkin_object().printTo(body);
+   return body;
+ }
+
+ JsonObject& THiNX::checkin_object() {
 
    //Serial.println("*TH: Building request...");
-   //Serial.print("*THiNXLib::checkin_body(): heap = ");
+   //Serial.print("*THiNXLib::checkin_object(): heap = ");
    //Serial.println(system_get_free_heap_size());
 
+   char hash[9];
+   checkin_hash = registration_hash();
+   sprintf(hash, "%08x", checkin_hash);
+
+   // Nothing changed since the last accepted check-in: send identity and hash only,
+   // API replies 304 unless it has changes for us.
+   checkin_conditional = (checkin_hash == checkin_hash_acked) && (strlen(thinx_udid) > 4);
+
    JsonObject& root = jsonBuffer.createObject();
    root["mac"] = thinx_mac();
+   root["hash"] = jsonBuffer.strdup(hash); // outlives this frame
+
+   if (checkin_conditional) {
+     root["udid"] = thinx_udid;
+     JsonObject& wrapper = jsonBuffer.createObject();
+     wrapper["registration"] = root;
+     return wrapper;
+   }
+
    root["firmware"] = THINX_FIRMWARE_VERSION;
    root["version"] = THINX_FIRMWARE_VERSION_SHORT;
    root["commit"] = THINX_COMMIT_ID;
@@ -305,20 +567,35 @@ void THiNX::connect_wifi() {
 
    // Serial.println("*TH: Wrapping request..."); OK until here...
 
-   JsonObject& wrapper = wrapperBuffer.createObject();
+   JsonObject& wrapper = jsonBuffer.createObject();
    wrapper["registration"] = root;
 
  #ifdef __DEBUG_JSON__
-   wrapper.printTo(Serial);
+   {
+     THiNXBufferedPrint out(Serial);
+     wrapper.printTo(out);
+   }
    Serial.println();
  #endif
 
-   String body;
-   wrapper.printTo(body);
-   return body;
+   return wrapper;
  }
 
-void THiNX::senddata(String body) {
+bool THiNX::senddata(String body) {
+  return senddata((const uint8_t*) body.c_str(), body.length(), "application/json");
+}
+
+bool THiNX::senddata(const uint8_t * body, size_t length, const char * content_type) {
+  if (!api_request(length, content_type)) return false;
+  if (thx_wifi_client->write(body, length) != length) {
+    Serial.println("*TH: Checkin body does not match its Content-Length, request dropped.");
+    thx_wifi_client->stop();
+    return false;
+  }
+  return api_response();
+}
+
+bool THiNX::api_request(size_t length, const char * content_type) {
 
   // Solution using the HTTPClient has no response parser yet:
   /*
@@ -341,15 +618,27 @@ void THiNX::senddata(String body) {
     thx_wifi_client->print("Host: "); thx_wifi_client->println(thinx_cloud_url);
     thx_wifi_client->print("Authentication: "); thx_wifi_client->println(thinx_api_key);
     thx_wifi_client->println("Accept: application/json"); // application/json
+    thx_wifi_client->println("Accept-Encoding: " THINX_LZSS_ENCODING);
     thx_wifi_client->println("Origin: device");
-    thx_wifi_client->println("Content-Type: application/json");
+    thx_wifi_client->print("Content-Type: "); thx_wifi_client->println(content_type);
+    if (checkin_conditional) {
+      thx_wifi_client->printf("If-None-Match: \"%08x\"\r\n", checkin_hash);
+    }
     thx_wifi_client->println("User-Agent: THiNX-Client");
     thx_wifi_client->print("Content-Length: ");
-    thx_wifi_client->println(body.length());
+    thx_wifi_client->println(length);
     thx_wifi_client->println();
     //Serial.println("Headers set...");
-    thx_wifi_client->println(body);
-    //Serial.println("Body sent...");
+    return true;
+
+  } else {
+    Serial.println("*TH: API connection failed.");
+    return false;
+  }
+//#endif
+}
+
+bool THiNX::api_response() {
 
     long interval = 10000;
     unsigned long currentMillis = millis(), previousMillis = millis();
@@ -361,37 +650,121 @@ void THiNX::senddata(String body) {
     while(!thx_wifi_client->available()){
       delay(1);
       if( (currentMillis - previousMillis) > interval ){
-        //Serial.println("Response Timeout. TODO: Should retry later.");
+        Serial.println("*TH: API response timeout.");
         thx_wifi_client->stop();
-        return;
+        return false;
       }
       currentMillis = millis();
     }
 
-    // Read while connected
+    // Read while connected; an LZSS body is decoded on the fly after headers
     String payload = "";
+    StreamString decoded;
+    THiNXLZSSDecoder decoder(decoded);
+    bool in_body = false;
+    bool compressed = false;
     while ( thx_wifi_client->connected() ) {
       delay(1);
       if ( thx_wifi_client->available() ) {
         char str = thx_wifi_client->read();
+        if (compressed) {
+          decoder.write(str);
+          continue;
+        }
         payload = payload + String(str);
+        if (!in_body && payload.endsWith("\r\n\r\n")) {
+          in_body = true;
+          compressed = (payload.indexOf("Content-Encoding: " THINX_LZSS_ENCODING) != -1);
+        }
+      }
+    }
+
+    if (compressed) {
+      if (!decoder.done()) {
+        Serial.println("*TH: Compressed API response incomplete.");
+        return false;
       }
+      payload += decoded;
+    }
+
+    // Status line "HTTP/1.1 304 ..."
+    int http_status = 0;
+    if (payload.startsWith("HTTP/")) {
+      http_status = payload.substring(payload.indexOf(' ') + 1).toInt();
+    }
+
+    if (http_status == 304) {
+      Serial.println("*TH: Registration not modified.");
+      return true; // JSON buffers and flash stay untouched
+    }
+
+#ifdef __USE_MSGPACK__
+    if (http_status == 415) {
+      Serial.println("*TH: API does not accept MessagePack, falling back to JSON.");
+      checkin_msgpack = false;
+      return false;
+    }
+#endif
+
+    if (http_status == 412) {
+      Serial.println("*TH: Registration hash unknown to API, sending full body next time.");
+      checkin_hash_acked = 0;
+      return false;
     }
 
     Serial.println("*THiNXLib::senddata(): parsing payload...");
     parse(payload);
+    return true;
+}
+
+/*
+ * Check-in Schedule
+ */
 
+// After a site-wide power outage all devices boot together; the first check-in
+// is delayed by a stable per-chip offset so /device/register sees a ramp, not a spike.
+void THiNX::checkin_schedule_initial() {
+  unsigned long spread = THINX_CHECKIN_SPREAD * 1000UL;
+  unsigned long offset = 0;
+  if (spread > 0) {
+    offset = (uint32_t)(ESP.getChipId() * 2654435761UL) % spread; // Knuth multiplicative hash
+  }
+  checkin_due = millis() + offset;
+  checkin_pending = true;
+  Serial.print("*TH: First check-in in "); Serial.print(offset); Serial.println(" ms");
+}
+
+// Periodic check-ins keep the initial per-device offset; a server-assigned slot wins once
+void THiNX::checkin_schedule_next() {
+  if (checkin_slot > 0) {
+    checkin_due = millis() + checkin_slot * 1000UL;
+    checkin_slot = 0;
+    checkin_pending = true;
+  } else if (checkin_interval > 0) {
+    checkin_due = millis() + checkin_interval * 1000UL;
+    checkin_pending = true;
   } else {
-    Serial.println("*TH: API connection failed.");
-    return;
+    checkin_pending = false;
   }
-//#endif
+}
+
+bool THiNX::checkin_is_due() {
+  if (!checkin_pending) return false;
+  if (!checked_in && (duty_cycle_seconds > 0)) return true; // wake time is precious
+  return (long)(millis() - checkin_due) >= 0;
 }
 
 /*
  * Response Parser
  */
 
+// Writable buffer of a String for in-place parsing: parseObject(char*) unescapes
+// and terminates strings inside it, so the JsonBuffer holds only nodes.
+// The String must outlive everything read from the result.
+static char * thinx_json_buffer(String & json) {
+  return json.length() ? &json[0] : NULL;
+}
+
 void THiNX::parse(String payload) {
 
   // TODO: Should parse response only for this device_id (which must be internal and not a mac)
@@ -399,30 +772,29 @@ void THiNX::parse(String payload) {
   payload_type ptype = Unknown;
 
   int startIndex = 0;
-  int endIndex = payload.length();
 
   int reg_index = payload.indexOf("{\"registration\"");
   int upd_index = payload.indexOf("{\"update\"");
   int not_index = payload.indexOf("{\"notification\"");
 
-  if (upd_index > startIndex) {
+  // MQTT payloads start with the envelope, HTTP responses with headers
+  if (upd_index >= startIndex) {
     startIndex = upd_index;
     ptype = UPDATE;
   }
 
-  if (reg_index > startIndex) {
+  if ((reg_index > startIndex) || ((reg_index == 0) && (ptype == Unknown))) {
     startIndex = reg_index;
-    endIndex = payload.indexOf("}}") + 2;
     ptype = REGISTRATION;
   }
 
-  if (not_index > startIndex) {
+  if ((not_index > startIndex) || ((not_index == 0) && (ptype == Unknown))) {
     startIndex = not_index;
-    endIndex = payload.indexOf("}}") + 2; // is this still needed?
     ptype = NOTIFICATION;
   }
 
-  String body = payload.substring(startIndex, endIndex);
+  // The envelope is decoded in place, straight into fixed-size fields
+  const char * body = payload.c_str() + startIndex;
 
 #ifdef __DEBUG__
     Serial.print("*TH: Parsing response: '");
@@ -430,38 +802,37 @@ void THiNX::parse(String payload) {
     Serial.println("'");
 #endif
 
-  JsonObject& root = jsonBuffer.parseObject(body.c_str());
-
-  if ( !root.success() ) {
-  Serial.println("Failed parsing root node.");
-    return;
-  }
-
   switch (ptype) {
 
     case UPDATE: {
 
-      JsonObject& update = root["update"];
-      Serial.println("TODO: Parse update payload...");
+      thinx_update_t update;
+      uint16_t truncated = 0;
+      if (THiNXBinding::decode(body, "update", update, &truncated) < 0) {
+        Serial.println("Failed parsing update node.");
+        return;
+      }
+
+      if (truncated & (THiNXBinding::mask<thinx_update_t>("url") | THiNXBinding::mask<thinx_update_t>("ott"))) {
+        Serial.print("*TH: Error: update URL does not fit THINX_UPDATE_URL_SIZE ");
+        Serial.print(THINX_UPDATE_URL_SIZE);
+        Serial.println(", update rejected.");
+        return;
+      }
 
-      // Parse update (work in progress)
-      String mac = update["mac"];
-      String this_mac = String(thinx_mac());
-      Serial.println(String("mac: ") + mac);
+      Serial.print("mac: "); Serial.println(update.mac);
 
-      if (!mac.equals(this_mac)) {
+      if (strcmp(update.mac, thinx_mac()) != 0) {
         Serial.println("*TH: Warning: firmware is dedicated to device with different MAC.");
       }
 
       // Check current firmware based on commit id and store Updated state...
-      String commit = update["commit"];
-      Serial.println(String("commit: ") + commit);
+      Serial.print("commit: "); Serial.println(update.commit);
 
       // Check current firmware based on version and store Updated state...
-      String version = update["version"];
-      Serial.println(String("version: ") + version);
+      Serial.print("version: "); Serial.println(update.version);
 
-      if ((commit == thinx_commit_id) && (version == thinx_version_id)) {
+      if ((strcmp(update.commit, thinx_commit_id) == 0) && (strcmp(update.version, thinx_version_id) == 0)) {
         if (strlen(available_update_url) > 5) {
           Serial.println("*TH: firmware has same commit_id as current and update availability is stored. Firmware has been installed.");
           available_update_url = "";
@@ -475,13 +846,18 @@ void THiNX::parse(String payload) {
 
       // In case automatic updates are disabled,
       // we must ask user to commence firmware update.
-      if (THINX_AUTO_UPDATE == false) {
+      if (thinx_auto_update == false) {
         if (mqtt_client) {
           Serial.println("mqtt_client->publish");
-          mqtt_client->publish(
-            thinx_mqtt_channel().c_str(),
-            "{ title: \"Update Available\", body: \"There is an update available for this device. Do you want to install it now?\", type: \"actionable\", response_type: \"bool\" }"
-          );
+          thinx_prompt_t prompt = {
+            "Update Available",
+            "There is an update available for this device. Do you want to install it now?",
+            "actionable",
+            "bool"
+          };
+          MQTT::PacketBuffer message(topics.length(THiNXTopics::DEVICE));
+          THiNXBinding::encode(message, prompt);
+          publish_buffer(THiNXTopics::DEVICE, message);
           mqtt_client->loop();
         }
 
@@ -495,20 +871,15 @@ void THiNX::parse(String payload) {
         // local url   = payload['url']
         // local type  = payload['type']
 
-        String type = update["type"];
-        Serial.print("Payload type: "); Serial.println(type);
-
-        String files = update["files"];
+        Serial.print("Payload type: "); Serial.println(update.type);
 
-        String url = update["url"]; // may be OTT URL
-        available_update_url = url.c_str();
-
-        String ott = update["ott"];
-        available_update_url = ott.c_str();
+        // may be OTT URL
+        available_update_url = strdup(update.ott[0] ? update.ott : update.url);
 
         save_device_info();
 
-        if (url) {
+        if (update.url[0]) {
+          String url = update.url;
           Serial.println("*TH: Force update URL must not contain HTTP!!! :" + url);
           url.replace("http://", "");
           // TODO: must not contain HTTP, extend with http://thinx.cloud/"
@@ -523,17 +894,18 @@ void THiNX::parse(String payload) {
     case NOTIFICATION: {
 
       // Currently, this is used for update only, can be extended with request_category or similar.
-      JsonObject& notification = root["notification"];
-
-      if ( !notification.success() ) {
+      thinx_notification_t notification;
+      if (THiNXBinding::decode(body, "notification", notification) < 0) {
         Serial.println("Failed parsing notification node.");
         return;
       }
 
-      String type = notification["response_type"];
-      if ((type == "bool") || (type == "boolean")) {
-        bool response = notification["response"];
-        if (response == true) {
+      // response is a literal or a string, both are bound as text
+      const char * type = notification.response_type;
+      const char * response = notification.response;
+
+      if ((strcmp(type, "bool") == 0) || (strcmp(type, "boolean") == 0)) {
+        if (strcmp(response, "true") == 0) {
           Serial.println("User allowed update using boolean.");
           if (strlen(available_update_url) > 4) {
             update_and_reboot(available_update_url);
@@ -543,14 +915,13 @@ void THiNX::parse(String payload) {
         }
       }
 
-      if ((type == "string") || (type == "String")) {
-        String response = notification["response"];
-        if (response == "yes") {
+      if ((strcmp(type, "string") == 0) || (strcmp(type, "String") == 0)) {
+        if (strcmp(response, "yes") == 0) {
           Serial.println("User allowed update using string.");
           if (strlen(available_update_url) > 4) {
             update_and_reboot(available_update_url);
           }
-        } else if (response == "no") {
+        } else if (strcmp(response, "no") == 0) {
           Serial.println("User denied update using string.");
         }
       }
@@ -559,56 +930,86 @@ void THiNX::parse(String payload) {
 
     case REGISTRATION: {
 
-      JsonObject& registration = root["registration"];
-
-      if ( !registration.success() ) {
+      thinx_registration_t registration;
+      uint16_t truncated = 0;
+      if (THiNXBinding::decode(body, "registration", registration, &truncated) < 0) {
         Serial.println("Failed parsing registration node.");
         return;
       }
 
-      bool success = registration["success"];
-      String status = registration["status"];
+      if (strcmp(registration.status, "OK") == 0) {
 
-      if (status == "OK") {
+        bool changed = false;
+        bool identity = false;              // owner or udid, the topics follow
 
-        String alias = registration["alias"];
-        if ( alias.length() > 0 ) {
-          thinx_alias = strdup(alias.c_str());
+        if ( (strlen(registration.alias) > 0) && (strcmp(registration.alias, thinx_alias) != 0) ) {
+          thinx_alias = strdup(registration.alias);
+          changed = true;
         }
 
-        String owner = registration["owner"];
-        if ( owner.length() > 0 ) {
-          thinx_owner = strdup(owner.c_str());
+        if ( (strlen(registration.owner) > 0) && (strcmp(registration.owner, thinx_owner) != 0) ) {
+          thinx_owner = strdup(registration.owner);
+          changed = true;
+          identity = true;
         }
 
-        String udid = registration["udid"];
-        if ( udid.length() > 4 ) {
-          thinx_udid = strdup(udid.c_str());
+        if ( (strlen(registration.udid) > 4) && (strcmp(registration.udid, thinx_udid) != 0) ) {
+          thinx_udid = strdup(registration.udid);
+          changed = true;
+          identity = true;
         }
 
-        save_device_info();
+        // Optional schedule hints from server, spread the fleet centrally
+        if (registration.checkin_interval > 0) {
+          checkin_interval = registration.checkin_interval;
+        }
+        if (registration.checkin_slot > 0) {
+          checkin_slot = registration.checkin_slot;
+        }
+
+        // Server accepts LZSS frames on MQTT (HTTP negotiates via Accept-Encoding)
+        mqtt_compress = (strcmp(registration.encoding, THINX_LZSS_ENCODING) == 0);
 
-      } else if (status == "FIRMWARE_UPDATE") {
+        // Registration accepted; hash of what we sent is our new ETag, unless
+        // the API changed our state (then the next check-in is a full one).
+        uint32_t acked = changed ? 0 : checkin_hash;
+        if (acked != checkin_hash_acked) {
+          checkin_hash_acked = acked;
+          changed = true;
+        }
 
-        String mac = registration["mac"];
-        Serial.println(String("mac: ") + mac);
+        if (changed) {
+          save_device_info();
+        }
+        if (identity) {
+          update_identity();
+        }
+
+      } else if (strcmp(registration.status, "FIRMWARE_UPDATE") == 0) {
+
+        Serial.print("mac: "); Serial.println(registration.mac);
         // TODO: must be current or 'ANY'
 
-        String commit = registration["commit"];
-        Serial.println(String("commit: ") + commit);
+        Serial.print("commit: "); Serial.println(registration.commit);
 
         // should not be same except for forced update
-        if (commit == thinx_commit_id) {
+        if (strcmp(registration.commit, thinx_commit_id) == 0) {
           Serial.println("*TH: Warning: new firmware has same commit_id as current.");
         }
 
-        String version = registration["version"];
-        Serial.println(String("version: ") + version);
+        Serial.print("version: "); Serial.println(registration.version);
+
+        if (truncated & THiNXBinding::mask<thinx_registration_t>("url")) {
+          Serial.print("*TH: Error: update URL does not fit THINX_UPDATE_URL_SIZE ");
+          Serial.print(THINX_UPDATE_URL_SIZE);
+          Serial.println(", update rejected.");
+          return;
+        }
 
         Serial.println("Starting update...");
 
-        String url = registration["url"];
-        if (url) {
+        if (registration.url[0]) {
+          String url = registration.url;
           Serial.println("*TH: Running update with URL that should not contain http! :" + url);
           url.replace("http://", "");
           update_and_reboot(url);
@@ -628,20 +1029,445 @@ void THiNX::parse(String payload) {
  * MQTT
  */
 
-// TODO: Should be called only on init and update (and store result for later)
+// Topics are formatted only here, on init and on registration change
+void THiNX::update_topics() {
+  if (!topics.build(thinx_owner, thinx_udid)) {
+    Serial.println("*TH: MQTT topics do not fit THINX_TOPIC_PREFIX_SIZE.");
+  }
+  update_routes();
+}
+
+// Owner or udid changed. Called from handlers too, so the trie is rebuilt
+// by apply_identity() once dispatch() has returned
+void THiNX::update_identity() {
+  identity_pending = true;
+}
+
+// Topics and routes follow, and the broker session holding the old filters
+// is dropped; the next connect starts a clean one and subscribes to the new
+// filters only
+void THiNX::apply_identity() {
+  if (!identity_pending) return;
+  identity_pending = false;
+  update_topics();
+  mqtt_subscribed = 0;
+  mqtt_clean_session = true;
+  if ((mqtt_client != NULL) && mqtt_client->connected()) {
+    Serial.println("*TH: MQTT identity changed, reconnecting.");
+    mqtt_client->disconnect();
+    mqtt_result = false; // reconnect from loop(), not counted as a failure
+  }
+}
+
+/*
+ * Inbound MQTT routing
+ */
+
+// Rebuilds the dispatcher trie from the current topics, built-in routes first
+void THiNX::update_routes() {
+
+  dispatcher.clear();
+  if (!topics.ready()) return;
+
+  dispatcher.add(topics.name(THiNXTopics::DEVICE).c_str(), on_envelope, this);
+  dispatcher.add(topics.name(THiNXTopics::UPDATE).c_str(), on_envelope, this);
+  dispatcher.add(topics.name(THiNXTopics::NOTIFICATION).c_str(), on_envelope, this);
+
+  dispatcher.add(topics.name(THiNXTopics::RPC).c_str(), on_rpc, this);
+  dispatcher.add(topics.name(THiNXTopics::SHADOW_DESIRED).c_str(), on_shadow, this);
+
+  add_command_route("reboot", on_reboot, this);
+  add_command_route("config", on_config, this);
+
+  for (uint8_t i = 0; i < commands_count; i++) {
+    add_command_route(commands[i].name, commands[i].func, commands[i].context);
+  }
+}
+
+bool THiNX::add_command_route(const char * command, thinx_handler_t func, void * context) {
+  char filter[THINX_TOPIC_PREFIX_SIZE + 64]; // "/command/" and the name
+  int length = snprintf(filter, sizeof(filter), "%s/%s", topics.name(THiNXTopics::COMMAND).c_str(), command);
+  if ((length < 0) || ((size_t) length >= sizeof(filter)) || !dispatcher.add(filter, func, context)) {
+    Serial.print("*TH: Cannot route command "); Serial.println(command);
+    return false;
+  }
+  return true;
+}
+
+bool THiNX::setCommandCallback(const char * command, thinx_handler_t func, void * context) {
+  if (commands_count >= THINX_COMMANDS) return false;
+  commands[commands_count].name = command;
+  commands[commands_count].func = func;
+  commands[commands_count].context = context;
+  commands_count++;
+  if (topics.ready()) {
+    return add_command_route(command, func, context);
+  }
+  return true;
+}
+
+void THiNX::mqtt_callback(const MQTT::Publish &pub) {
+
+  // Payloads over MQTT_TOO_BIG arrive as a stream: firmware pushed over MQTT
+  if (pub.has_stream()) {
+    Serial.println("*TH: MQTT Type: Stream...");
+    uint32_t startTime = millis();
+    uint32_t size = pub.payload_len();
+    if ( ESP.updateSketch(*pub.payload_stream(), size, true, false) ) {
+      mqtt_client->publish(topics.ref(THiNXTopics::STATUS), "{ \"status\" : \"rebooting\" }");
+      mqtt_client->disconnect();
+      pub.payload_stream()->stop();
+      Serial.printf("Update Success: %lu\nRebooting...\n", millis() - startTime);
+      ESP.restart();
+    }
+    return;
+  }
+
+  String topic = pub.topic();
+  uint8_t called = 0;
+  bool dispatched = false;
+
+  // Only a server that takes LZSS frames sends them; a payload that merely
+  // starts with "LZ", or does not decode, is dispatched as it came
+  if (mqtt_compress && THiNXLZSS::is_frame(pub.payload(), pub.payload_len())) {
+    StreamString decoded;
+    THiNXLZSSDecoder decoder(decoded);
+    decoder.write(pub.payload(), pub.payload_len());
+    if (decoder.done()) {
+      called = dispatcher.dispatch(topic.c_str(), (const uint8_t*) decoded.c_str(), decoded.length());
+      dispatched = true;
+    }
+  }
+  if (!dispatched) {
+    called = dispatcher.dispatch(topic.c_str(), pub.payload(), pub.payload_len());
+  }
+
+  if (called == 0) {
+    Serial.print("*TH: No route for "); Serial.println(topic);
+  }
+}
+
+// Handler payloads are not terminated
+static String thinx_payload_string(const uint8_t * payload, size_t length) {
+  String str;
+  str.reserve(length);
+  for (size_t i = 0; i < length; i++) {
+    str += (char) payload[i];
+  }
+  return str;
+}
+
+/*
+ * RPC over MQTT
+ */
+
+bool THiNX::setMethodCallback(const char * method, THiNXRPC::method_t func, void * context) {
+  return rpc.method(method, func, context);
+}
+
+// Publishes a response (result or error) on the outbound RPC topic
+bool THiNX::rpc_publish(const char * id, JsonObject * result, const char * error) {
+  if ((mqtt_client == NULL) || !mqtt_client->connected()) return false;
+  THiNXJsonBuffer buffer;
+  JsonObject& response = buffer.createObject();
+  response["id"] = id;
+  if (error != NULL) {
+    response["error"] = error;
+  } else {
+    response["result"] = *result;
+  }
+  return publish_json(THiNXTopics::RPC_OUT, response);
+}
+
+bool THiNX::respond(const char * id, JsonObject & result) {
+  if (!rpc.end(id, true)) return false; // expired, the caller got "timeout" already
+  return rpc_publish(id, &result, NULL);
+}
+
+bool THiNX::respondError(const char * id, const char * error) {
+  if (!rpc.end(id, true)) return false;
+  return rpc_publish(id, NULL, error);
+}
+
+const char * THiNX::call(const char * method, JsonObject & params, THiNXRPC::reply_t reply, void * context, unsigned long timeout) {
+
+  if ((mqtt_client == NULL) || !mqtt_client->connected()) return NULL;
+
+  const char * id = rpc.next_id();
+  if (!rpc.begin(id, false, timeout, reply, context)) return NULL;
+
+  THiNXJsonBuffer buffer;
+  JsonObject& request = buffer.createObject();
+  request["id"] = id;
+  request["method"] = method;
+  request["params"] = params;
+
+  if (!publish_json(THiNXTopics::RPC_OUT, request)) {
+    rpc.end(id, false);
+    return NULL;
+  }
+  return id;
+}
+
+// Answers overdue calls: "timeout" to the server or to the local reply callback
+void THiNX::rpc_expire() {
+  bool inbound;
+  THiNXRPC::reply_t reply;
+  void * context;
+  const char * id;
+  while ((id = rpc.expire(millis(), &inbound, &reply, &context)) != NULL) {
+    if (inbound) {
+      rpc_publish(id, NULL, "timeout");
+    } else if (reply) {
+      reply(id, JsonVariant(), "timeout", context);
+    }
+  }
+}
+
+void THiNX::on_rpc(const char * topic, const uint8_t * payload, size_t length, void * context) {
+
+  THiNX * thx = (THiNX *) context;
+  String body = thinx_payload_string(payload, length);
+  THiNXJsonBuffer buffer; // per message, freed on return
+  JsonObject& message = buffer.parseObject(thinx_json_buffer(body));
+
+  if (!message.success()) {
+    Serial.println("*TH: Failed parsing RPC message.");
+    return;
+  }
+
+  String id = message["id"].as<String>(); // string or number
+  if ((id.length() == 0) || (id.length() >= THINX_RPC_ID_SIZE)) {
+    Serial.println("*TH: RPC message without valid id.");
+    return;
+  }
+
+  const char * method = message["method"];
+
+  // Reply to a call made by the device
+  if (method == NULL) {
+    THiNXRPC::reply_t reply = NULL;
+    void * reply_context = NULL;
+    if (thx->rpc.end(id.c_str(), false, &reply, &reply_context) && reply) {
+      reply(id.c_str(), message["result"], message["error"], reply_context);
+    }
+    return;
+  }
+
+  void * method_context = NULL;
+  THiNXRPC::method_t func = thx->rpc.find(method, &method_context);
+  if (func == NULL) {
+    thx->rpc_publish(id.c_str(), NULL, "unknown method");
+    return;
+  }
+
+  JsonObject& params = message["params"].is<JsonObject&>() ? message["params"].as<JsonObject&>() : buffer.createObject();
+  JsonObject& result = buffer.createObject();
+
+  switch (func(id.c_str(), params, result, method_context)) {
+    case THiNXRPC::OK:
+      thx->rpc_publish(id.c_str(), &result, NULL);
+      break;
+    case THiNXRPC::PENDING:
+      if (!thx->rpc.begin(id.c_str(), true, THINX_RPC_TIMEOUT)) {
+        thx->rpc_publish(id.c_str(), NULL, "busy");
+      }
+      break;
+    case THiNXRPC::ERROR: {
+      const char * error = result["message"];
+      thx->rpc_publish(id.c_str(), NULL, error ? error : "failed");
+    } break;
+  }
+}
+
+THiNXRPC::status_t THiNX::method_config_read(const char * id, JsonObject & params, JsonObject & result, void * context) {
+  THiNX * thx = (THiNX *) context;
+  result["alias"] = thx->thinx_alias;
+  result["owner"] = thx->thinx_owner;
+  result["udid"] = thx->thinx_udid;
+  result["firmware"] = THINX_FIRMWARE_VERSION;
+  result["version"] = THINX_FIRMWARE_VERSION_SHORT;
+  result["commit"] = THINX_COMMIT_ID;
+  result["platform"] = THINX_PLATFORM;
+  result["auto_update"] = thx->thinx_auto_update;
+  result["checkin_interval"] = thx->checkin_interval;
+  return THiNXRPC::OK;
+}
+
+THiNXRPC::status_t THiNX::method_diagnostics(const char * id, JsonObject & params, JsonObject & result, void * context) {
+  THiNX * thx = (THiNX *) context;
+  result["heap"] = ESP.getFreeHeap();
+  result["uptime"] = millis();
+  result["rssi"] = WiFi.RSSI();
+  result["wake"] = thx->session_wake_count;
+  result["wifi_failures"] = thx->wifi_backoff.failures();
+  result["api_failures"] = thx->api_backoff.failures();
+  result["mqtt_failures"] = thx->mqtt_backoff.failures();
+  result["telemetry_lost"] = thx->telemetry.lost();
+  if (thx->mqtt_client != NULL) {
+    const PubSubClient::ping_stats_t & ping = thx->mqtt_client->ping_stats();
+    JsonObject & keepalive = result.createNestedObject("keepalive");
+    keepalive["interval"] = ping.interval;
+    keepalive["good"] = ping.good;
+    keepalive["ceiling"] = ping.ceiling;
+    keepalive["sent"] = ping.sent;
+    keepalive["answered"] = ping.answered;
+    keepalive["suppressed"] = ping.suppressed;
+    keepalive["timeouts"] = ping.timeouts;
+    keepalive["raised"] = ping.raised;
+    keepalive["lowered"] = ping.lowered;
+  }
+  thx->json_stats(result);
+  return THiNXRPC::OK;
+}
+
+#if ARDUINOJSON_ENABLE_STATS
+static void thinx_json_stats(JsonObject & object, const JsonBufferStats & stats, size_t capacity) {
+  object["capacity"] = capacity;
+  object["peak"] = stats.peak;
+  object["largest"] = stats.largest;             // single parsed document
+  object["allocs"] = stats.allocations;
+  object["failures"] = stats.failures;
+  if (stats.failures > 0) {                      // last one
+    object["failed_type"] = JsonBufferStats::typeName(stats.failedType);
+    object["failed_size"] = stats.failedSize;
+    object["failed_at"] = stats.failedAt;
+  }
+}
+#endif
+
+// Usage of the shared arena and of the per-message pool buffers, fleet data
+// for THINX_JSON_BUFFER_SIZE and THINX_JSON_POOL_BLOCK
+void THiNX::json_stats(JsonObject & status) {
+#if ARDUINOJSON_ENABLE_STATS
+  JsonObject & json = status.createNestedObject("json");
+  thinx_json_stats(json.createNestedObject("arena"), jsonBuffer.stats(), jsonBuffer.capacity());
+  thinx_json_stats(json.createNestedObject("pool"), THiNXJsonBuffer::totals(),
+                   THINX_JSON_POOL_BLOCK - thinx_json_pool_t::blockOverhead);
+#endif
+}
+
+// Approves the update announced by the last UPDATE envelope; installs after replying
+THiNXRPC::status_t THiNX::method_update_approve(const char * id, JsonObject & params, JsonObject & result, void * context) {
+  THiNX * thx = (THiNX *) context;
+  if (strlen(thx->available_update_url) < 5) {
+    result["message"] = "no update available";
+    return THiNXRPC::ERROR;
+  }
+  result["url"] = thx->available_update_url;
+  thx->update_approved = true;
+  return THiNXRPC::OK;
+}
+
+/*
+ * Device Shadow
+ */
+
+void THiNX::shadow_begin() {
+  shadow.begin(THINX_EEPROM_INFO_SIZE, THINX_SHADOW_EEPROM_SIZE);
+  shadow.field("alias", &thinx_alias, THINX_ALIAS_SIZE);
+  shadow.field("owner", &thinx_owner, THINX_OWNER_SIZE);
+  shadow.field("auto_update", &thinx_auto_update);
+  shadow.field("available_update_url", &available_update_url, THINX_UPDATE_URL_SIZE);
+  shadow.field("checkin_interval", &checkin_interval);
+  shadow.setCallback(on_shadow_change, this);
+}
+
+// Persists local changes and publishes pending fields as one reported delta
+void THiNX::shadow_sync() {
+
+  if (millis() - shadow_last_scan >= THINX_SHADOW_SCAN) {
+    shadow_last_scan = millis();
+    shadow.scan();
+  }
+
+  if (!shadow.pending()) return;
+
+  THiNXJsonBuffer buffer;
+  JsonObject& root = buffer.createObject();
+  shadow.report(root);
+  if (publish_json(THiNXTopics::SHADOW_REPORTED, root)) {
+    shadow.reported();
+  }
+}
+
+void THiNX::on_shadow(const char * topic, const uint8_t * payload, size_t length, void * context) {
+  THiNX * thx = (THiNX *) context;
+  String body = thinx_payload_string(payload, length);
+  THiNXJsonBuffer buffer;
+  JsonObject& message = buffer.parseObject(thinx_json_buffer(body));
+  if (!message.success()) {
+    Serial.println("*TH: Failed parsing shadow delta.");
+    return;
+  }
+  thx->shadow.apply(message);
+}
+
+void THiNX::on_shadow_change(const char * key, void * context) {
+
+  THiNX * thx = (THiNX *) context;
+  Serial.print("*TH: Shadow changed "); Serial.println(key);
+
+  if (strcmp(key, "owner") == 0) {
+    thx->update_identity();
+  }
+
+  if ((strcmp(key, "available_update_url") == 0) && thx->thinx_auto_update) {
+    thx->update_approved = (strlen(thx->available_update_url) > 4);
+  }
+}
+
+/*
+ * Copies
+ */
+
+void THiNX::rpc_methods() {
+  rpc.method("config.read", method_config_read, this);
+  rpc.method("diagnostics", method_diagnostics, this);
+  rpc.method("update.approve", method_update_approve, this);
+}
+
+// Update, notification and registration envelopes, same as API responses
+void THiNX::on_envelope(const char * topic, const uint8_t * payload, size_t length, void * context) {
+  THiNX * thx = (THiNX *) context;
+  thx->parse(thinx_payload_string(payload, length));
+}
+
+void THiNX::on_reboot(const char * topic, const uint8_t * payload, size_t length, void * context) {
+  THiNX * thx = (THiNX *) context;
+  Serial.println("*TH: Reboot requested over MQTT.");
+  thx->mqtt_client->publish(thx->topics.ref(THiNXTopics::STATUS), "{ \"status\" : \"rebooting\" }");
+  thx->mqtt_client->disconnect();
+  ESP.restart();
+}
+
+// { "alias" : "...", "checkin_interval" : 3600 }
+void THiNX::on_config(const char * topic, const uint8_t * payload, size_t length, void * context) {
+  THiNX * thx = (THiNX *) context;
+  String body = thinx_payload_string(payload, length);
+  StaticJsonBufferBase::Scope scope(thx->jsonBuffer);
+  JsonObject& config = thx->jsonBuffer.parseObject(thinx_json_buffer(body));
+  if (!config.success()) {
+    Serial.println("*TH: Failed parsing config command.");
+    return;
+  }
+  const char * alias = config["alias"];
+  if ((alias != NULL) && (strcmp(alias, thx->thinx_alias) != 0)) {
+    thx->thinx_alias = strdup(alias);
+    thx->save_device_info();
+  }
+  long interval = config["checkin_interval"];
+  if (interval > 0) {
+    thx->checkin_interval = interval;
+  }
+}
+
 String THiNX::thinx_mqtt_channel() {
-  //char * channel;
-  //sprintf(channel, "/%s/%s", thinx_owner, thinx_udid);
-  sprintf(mqtt_device_channel, "/%s/%s", thinx_owner, thinx_udid);
-  return String(mqtt_device_channel);
+  return String(topics.name(THiNXTopics::DEVICE).c_str());
 }
 
-// TODO: Should be called only on init and update (and store result for later)
 String THiNX::thinx_mqtt_status_channel() {
-  //char * channel;
-  //sprintf(channel, "/%s/%s/status", thinx_owner, thinx_udid);
-  sprintf(mqtt_device_status_channel, "/%s/%s/status", thinx_owner, thinx_udid);
-  return String(mqtt_device_status_channel);
+  return String(topics.name(THiNXTopics::STATUS).c_str());
 }
 
 // TODO: FIXME: Return real mac address through WiFi? Might solve compatibility issues.
@@ -666,30 +1492,239 @@ void THiNX::publish() {
   if (!connected) return;
   if (mqtt_client == NULL) return;
   if (strlen(thinx_udid) < 4) return;
-  String channel = thinx_mqtt_status_channel();
-  String response = "{ \"status\" : \"connected\" }";
   if (mqtt_client->connected()) {
     Serial.println("*TH: MQTT connected, publishing status...");
-    mqtt_client->publish(mqtt_device_status_channel, response.c_str());
+    publish_status();
     //mqtt_client->loop();
   } else {
-    Serial.println("*TH: MQTT not connected, reconnecting...");
-    mqtt_result = start_mqtt();
-    if (mqtt_result && mqtt_client->connected()) {
-      mqtt_client->publish(channel, response.c_str());
+    if (mqtt_reconnect()) {
+      publish_status();
       //mqtt_client->loop();
       Serial.println("*TH: MQTT reconnected, published default message.");
     } else {
-      Serial.println("*TH: MQTT Reconnect failed...");
+      Serial.println("*TH: MQTT not connected, status not published.");
+    }
+  }
+}
+
+void THiNX::publish_status() {
+#if ARDUINOJSON_ENABLE_STATS
+  THiNXJsonBuffer buffer;
+  JsonObject& status = buffer.createObject();
+  status["status"] = "connected";
+  json_stats(status);
+#ifdef __USE_MSGPACK__
+  if (publish_msgpack(THiNXTopics::STATUS_MSGPACK, status)) return;
+#endif
+  publish_json(THiNXTopics::STATUS, status);
+#else
+#ifdef __USE_MSGPACK__
+  if (checkin_msgpack) {
+    static const uint8_t connected[] = { // {"status":"connected"}
+      0x81, 0xA6, 's', 't', 'a', 't', 'u', 's', 0xA9, 'c', 'o', 'n', 'n', 'e', 'c', 't', 'e', 'd'
+    };
+    publish_payload(THiNXTopics::STATUS_MSGPACK, connected, sizeof(connected));
+    return;
+  }
+#endif
+  mqtt_client->publish(topics.ref(THiNXTopics::STATUS), "{ \"status\" : \"connected\" }");
+#endif
+}
+
+#ifdef __USE_MSGPACK__
+// Same server side as the check-in, so only while the API takes MessagePack;
+// false (send JSON instead) after a 415 or when the frame does not fit
+bool THiNX::publish_msgpack(THiNXTopics::topic_id id, JsonObject & object) {
+  if (!checkin_msgpack) return false;
+  THiNXMsgPack packer(buf, sizeof(buf));
+  packer.value(object);
+  if (packer.overflowed()) return false;
+  publish_payload(id, buf, packer.size());
+  return true;
+}
+#endif
+
+#ifdef __USE_SPIFFS__
+
+static uint32_t thinx_clock_base;          // device clock (ms) at millis() 0 of this wake
+static bool thinx_clock_unmarked;           // restart not yet recorded in the flash tier
+static bool thinx_spill_opened;             // this wake's header is in the flash tier
+
+// The clock continues only over a deep-sleep wake (to within the boot time)
+void THiNX::telemetry_clock_restore() {
+  thinx_clock_t clock;
+  thinx_spill_opened = false;
+  if ((ESP.getResetInfoPtr()->reason == REASON_DEEP_SLEEP_AWAKE) &&
+      ESP.rtcUserMemoryRead(THINX_RTC_CLOCK, (uint32_t*) &clock, sizeof(clock)) &&
+      (clock.crc == crc32(&clock.base, sizeof(clock) - sizeof(clock.crc)))) {
+    thinx_clock_base = clock.base;
+    thinx_clock_unmarked = clock.unmarked;
+    return;
+  }
+  thinx_clock_base = 0;
+  thinx_clock_unmarked = true;
+}
+
+void THiNX::telemetry_clock_store() {
+  thinx_clock_t clock;
+  clock.base = thinx_clock_base + millis() + duty_cycle_seconds * 1000UL;
+  clock.unmarked = thinx_clock_unmarked;
+  clock.crc = crc32(&clock.base, sizeof(clock) - sizeof(clock.crc));
+  ESP.rtcUserMemoryWrite(THINX_RTC_CLOCK, (uint32_t*) &clock, sizeof(clock));
+}
+
+// Flash tier: buckets pushed out of RAM while offline, appended as raw
+// records behind a header holding the clock of their wake
+bool THiNX::telemetry_spill(const thinx_bucket_t & bucket) {
+  File f = SPIFFS.open(THINX_TELEMETRY_FILE, "a");
+  if (!f) return false;
+  bool kept = false;
+  if (f.size() < THINX_TELEMETRY_FLASH_BUCKETS * sizeof(thinx_bucket_t)) {
+    kept = true;
+    if (!thinx_spill_opened) {
+      thinx_bucket_t header;
+      memset(&header, 0, sizeof(header));
+      if (thinx_clock_unmarked && (f.size() > 0)) {
+        header.channel = THINX_SPILL_POWER_ON;
+        kept = (f.write((const uint8_t*) &header, sizeof(header)) == sizeof(header));
+      }
+      header.channel = THINX_SPILL_WAKE;
+      header.start = thinx_clock_base;
+      kept = kept && (f.write((const uint8_t*) &header, sizeof(header)) == sizeof(header));
+      thinx_clock_unmarked = thinx_clock_unmarked && !kept;
+      thinx_spill_opened = kept;
+    }
+    kept = kept && (f.write((const uint8_t*) &bucket, sizeof(bucket)) == sizeof(bucket));
+  }
+  f.close();
+  return kept;
+}
+
+// Publishes the flash tier oldest-first in RAM-sized chunks, removes it when
+// all went out. Bucket starts are moved onto the device clock, "up" is that
+// clock now. Buckets recorded before a restart go out with the number of
+// restarts since ("reboots") instead, as their time is only known relative
+// to each other.
+bool THiNX::telemetry_drain() {
+  if (!SPIFFS.exists(THINX_TELEMETRY_FILE)) {
+    thinx_clock_unmarked = false;
+    return true;
+  }
+  File f = SPIFFS.open(THINX_TELEMETRY_FILE, "r");
+  if (!f) return false;
+
+  thinx_bucket_t record;
+  uint16_t reboots = thinx_clock_unmarked ? 1 : 0;
+  while (f.read((uint8_t*) &record, sizeof(record)) == sizeof(record)) {
+    if ((record.count == 0) && (record.channel == THINX_SPILL_POWER_ON)) reboots++;
+  }
+  f.seek(0);
+
+  thinx_bucket_t * chunk = new thinx_bucket_t[THINX_TELEMETRY_BUCKETS];
+  bool result = true;
+  size_t count = 0;
+  uint16_t chunk_reboots = reboots;
+  uint32_t base = 0;
+  while (result) {
+    bool more = (f.read((uint8_t*) &record, sizeof(record)) == sizeof(record));
+    if (more && (record.count == 0)) {
+      if (record.channel == THINX_SPILL_POWER_ON) {
+        reboots--;
+        base = 0;
+      } else {
+        base = record.start;
+      }
+    }
+    if (count && (!more || (count == THINX_TELEMETRY_BUCKETS) || (reboots != chunk_reboots))) {
+      result = telemetry_drain_chunk(chunk, count, chunk_reboots);
+      count = 0;
+    }
+    if (!more) break;
+    if (record.count == 0) continue;
+    if (count == 0) chunk_reboots = reboots;
+    record.start += base;
+    chunk[count++] = record;
+  }
+  delete [] chunk;
+  f.close();
+  if (result) {
+    SPIFFS.remove(THINX_TELEMETRY_FILE); // a failed drain is retried in full
+    thinx_spill_opened = false;
+    thinx_clock_unmarked = false;
+  }
+  return result;
+}
+
+bool THiNX::telemetry_drain_chunk(const thinx_bucket_t * buckets, size_t count, uint16_t reboots) {
+#ifdef __USE_MSGPACK__
+  if (checkin_msgpack) {
+    size_t capacity = 24 + count * 24;      // header and keys, then as THiNXTelemetry::packedSize()
+    uint8_t * frame = new uint8_t[capacity];
+    THiNXMsgPack packer(frame, capacity);
+    packer.map(2);
+    if (reboots) {
+      packer.str("reboots"); packer.uinteger(reboots);
+    } else {
+      packer.str("up"); packer.uinteger(thinx_clock_base + millis());
     }
+    packer.str("b"); packer.array(count * 6);
+    THiNXTelemetry::packBuckets(packer, buckets, count);
+    bool result = !packer.overflowed() && publish_payload(THiNXTopics::TELEMETRY_MSGPACK, frame, packer.size());
+    delete [] frame;
+    mqtt_client->loop();
+    return result;
   }
+#endif
+  MQTT::PacketBuffer batch(topics.length(THiNXTopics::TELEMETRY));
+  if (reboots) {
+    batch.print("{\"reboots\":"); batch.print(reboots);
+  } else {
+    batch.print("{\"up\":"); batch.print((unsigned long) (thinx_clock_base + millis()));
+  }
+  batch.print(",\"b\":[");
+  THiNXTelemetry::printBuckets(batch, buckets, count);
+  batch.print("]}");
+  bool result = publish_buffer(THiNXTopics::TELEMETRY, batch);
+  mqtt_client->loop();
+  return result;
+}
+
+#endif
+
+// Sends queued samples as one batch; they stay queued when publishing fails
+bool THiNX::publish_telemetry() {
+  if ((mqtt_client == NULL) || !mqtt_client->connected()) return false;
+#ifdef __USE_SPIFFS__
+  if (!telemetry_drain()) return false;     // flash tier holds the oldest data
+#endif
+  if (telemetry.count() == 0) return false;
+#ifdef __USE_MSGPACK__
+  if (checkin_msgpack) {
+    size_t capacity = telemetry.packedSize();
+    uint8_t * frame = new uint8_t[capacity];
+    THiNXMsgPack packer(frame, capacity);
+    telemetry.packTo(packer, millis());
+    bool result = !packer.overflowed() && publish_payload(THiNXTopics::TELEMETRY_MSGPACK, frame, packer.size());
+    delete [] frame;
+    if (!result) return false;
+    telemetry.clear();
+    return true;
+  }
+#endif
+  MQTT::PacketBuffer batch(topics.length(THiNXTopics::TELEMETRY));
+  telemetry.printTo(batch, millis());
+  if (!publish_buffer(THiNXTopics::TELEMETRY, batch)) {
+    return false;
+  }
+  telemetry.clear();
+  return true;
 }
 
 void THiNX::notify_on_successful_update() {
   if (mqtt_client) {
     Serial.println("mqtt_client->publish");
     mqtt_client->publish(
-      mqtt_device_status_channel,
+      topics.ref(THiNXTopics::STATUS),
       "{ title: \"Update Successful\", body: \"The device has been successfully updated.\", type: \"success\" }"
     );
     mqtt_client->loop();
@@ -698,30 +1733,89 @@ void THiNX::notify_on_successful_update() {
   }
 }
 
+// Connects only when the backoff allows an attempt, so it never blocks the loop
+// on a broker that is known to be unreachable.
+// Publishes as an LZSS frame when the server accepts it and it saves bytes
+bool THiNX::publish_payload(THiNXTopics::topic_id id, const uint8_t * payload, size_t length) {
+  if (mqtt_client == NULL) return false;
+  if (mqtt_compress && (length >= THINX_COMPRESS_THRESHOLD)) {
+    uint8_t * frame = new uint8_t[length];
+    size_t size = THiNXLZSS::compress(payload, length, frame, length);
+    bool result = false;
+    if (size > 0) {
+      result = mqtt_client->publish(topics.ref(id), frame, size);
+    }
+    delete [] frame;
+    if (size > 0) return result;
+  }
+  return mqtt_client->publish(topics.ref(id), payload, length);
+}
+
+bool THiNX::publish_json(THiNXTopics::topic_id id, JsonObject & object) {
+  if (mqtt_client == NULL) return false;
+  MQTT::PacketBuffer body(topics.length(id));
+  object.printTo(body);
+  return publish_buffer(id, body);
+}
+
+// The payload becomes the packet, headers are written in front of it
+bool THiNX::publish_buffer(THiNXTopics::topic_id id, MQTT::PacketBuffer & body) {
+  if ((mqtt_client == NULL) || body.failed()) return false;
+  if (mqtt_compress && (body.length() >= THINX_COMPRESS_THRESHOLD)) {
+    return publish_payload(id, body.payload(), body.length());
+  }
+  MQTT::Publish message(topics.ref(id), body);
+  return mqtt_client->publish(message);
+}
+
+bool THiNX::mqtt_reconnect() {
+
+  if ((mqtt_client != NULL) && mqtt_client->connected()) {
+    return true;
+  }
+
+  if (!mqtt_backoff.attempt(millis())) {
+    return false;
+  }
+
+  Serial.println("*TH: MQTT not connected, reconnecting...");
+  mqtt_result = start_mqtt();
+  if (mqtt_result) {
+    mqtt_backoff.success();
+  } else {
+    mqtt_backoff.failure(millis());
+    Serial.print("*TH: MQTT reconnect failed, next attempt in ");
+    Serial.print(mqtt_backoff.next_attempt() - millis()); Serial.println(" ms");
+  }
+  return mqtt_result;
+}
+
 bool THiNX::start_mqtt() {
 
-  if (mqtt_client != NULL) {
-    if (mqtt_client->connected()) {
-      return true;
-    } else {
-      return false;
-    }
+  if ((mqtt_client != NULL) && mqtt_client->connected()) {
+    return true;
   }
 
   if (strlen(thinx_udid) < 4) {
     return false;
   }
 
-  Serial.print("*TH: UDID: "); Serial.println(thinx_udid);
-  Serial.print("*TH: Contacting MQTT server "); Serial.println(thinx_mqtt_url);
-  Serial.print("*TH: MQTT client with URL "); Serial.println(thinx_mqtt_url);
+  if (mqtt_client == NULL) {
 
-  mqtt_client = new PubSubClient(*thx_wifi_client, thinx_mqtt_url);
+    Serial.print("*TH: UDID: "); Serial.println(thinx_udid);
+    Serial.print("*TH: Contacting MQTT server "); Serial.println(thinx_mqtt_url);
+    Serial.print("*TH: MQTT client with URL "); Serial.println(thinx_mqtt_url);
 
-  Serial.print(" started on port ");
-  Serial.println(thinx_mqtt_port);
+    mqtt_client = new PubSubClient(*thx_wifi_client, thinx_mqtt_url);
+    mqtt_client->set_next_packet_id(mqtt_packet_id); // from RTC after deep-sleep, else 0
+    mqtt_client->set_adaptive_ping(THINX_MQTT_PING_MIN, mqtt_ping_interval);
+    mqtt_client->set_callback([this](const MQTT::Publish &pub) {
+      mqtt_callback(pub);
+    });
 
-  last_mqtt_reconnect = 0;
+    Serial.print(" started on port ");
+    Serial.println(thinx_mqtt_port);
+  }
 
   if (strlen(thinx_api_key) < 5) {
     Serial.println("*TH: API Key not set, exiting.");
@@ -730,13 +1824,18 @@ bool THiNX::start_mqtt() {
 
   Serial.print("*TH: AK: ");
   Serial.println(thinx_api_key);
+  apply_identity();
+  if (!topics.ready()) {
+    update_topics();
+  }
+
   Serial.print("*TH: DCH: ");
-  Serial.println(String(thinx_mqtt_channel()));
+  Serial.println(topics.name(THiNXTopics::DEVICE).c_str());
 
   const char* id = thinx_mac();
   const char* user = thinx_udid;
   const char* pass = thinx_api_key;
-  String willTopic = thinx_mqtt_status_channel();
+  THiNXTopics::name_t willTopic = topics.name(THiNXTopics::STATUS);
   int willQos = 0;
   bool willRetain = false;
 
@@ -747,60 +1846,67 @@ bool THiNX::start_mqtt() {
   if (mqtt_client->connect(MQTT::Connect(id)
                 .set_will(willTopic.c_str(), "{ \"status\" : \"disconnected\" }")
                 .set_auth(user, pass)
-                .set_keepalive(30)
+                .set_keepalive(THINX_MQTT_KEEPALIVE)
+                .set_clean_session(!THINX_MQTT_PERSISTENT_SESSION || mqtt_clean_session)
               )) {
 
         Serial.println("mqtt_client->connected()!");
+        mqtt_clean_session = false;
 
         mqtt_connected = true;
         perform_mqtt_checkin = true;
 
-        /*
-
-        mqtt_client->set_callback([this](const MQTT::Publish &pub){
+        mqtt_subscribe();
 
-          delay(1);
+        shadow.touch(); // full report once per connection, deltas afterwards
 
-          // >
-          if (pub.has_stream()) {
-            Serial.println("*TH: MQTT Type: Stream...");
-            uint32_t startTime = millis();
-            uint32_t size = pub.payload_len();
+        return true;
 
-            if ( ESP.updateSketch(*pub.payload_stream(), size, true, false) ) {
+      } else {
 
-              // Notify on reboot for update
-              mqtt_client->publish(
-                mqtt_device_status_channel,
-                "{ \"status\" : \"rebooting\" }"
-              );
-              mqtt_client->disconnect();
-              pub.payload_stream()->stop();
-              Serial.printf("Update Success: %u\nRebooting...\n", millis() - startTime);
-              ESP.restart();
-            }
+        Serial.println("*TH: MQTT Not connected.");
+        return false;
+      }
+}
 
-            Serial.println("stop.");
+// Broker-side filters, the dispatcher routes within them
+static const THiNXTopics::topic_id thinx_subscriptions[] = {
+  THiNXTopics::DEVICE,
+  THiNXTopics::COMMAND_ALL,
+  THiNXTopics::UPDATE,
+  THiNXTopics::NOTIFICATION,
+  THiNXTopics::RPC,
+  THiNXTopics::SHADOW_DESIRED
+};
 
-          } else {
-          // <
+// One SUBSCRIBE for all filters, skipped when the broker resumed a session holding them
+bool THiNX::mqtt_subscribe() {
 
+  const uint8_t count = sizeof(thinx_subscriptions) / sizeof(thinx_subscriptions[0]);
 
-            //Serial.println("*TH: MQTT Type: String or JSON (NOT PARSED NOW!)...");
-            Serial.println(pub.payload_string());
-            //parse(pub.payload_string());
-          // }
-      }); // end-of-callback
+  uint32_t hash = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    hash = crc32(topics.name(thinx_subscriptions[i]).c_str(), topics.length(thinx_subscriptions[i]) + 1, hash);
+  }
 
-      */
+  if (mqtt_client->session_present() && (hash == mqtt_subscribed)) {
+    Serial.println("*TH: MQTT session resumed, subscriptions kept.");
+    return true;
+  }
 
-        return true;
+  MQTT::Subscribe subscription;
+  for (uint8_t i = 0; i < count; i++) {
+    subscription.add_topic(topics.name(thinx_subscriptions[i]).c_str(), THINX_MQTT_QOS);
+  }
 
-      } else {
+  if (!mqtt_client->subscribe(subscription)) {
+    Serial.println("*TH: MQTT subscribe failed.");
+    mqtt_subscribed = 0;
+    return false;
+  }
 
-        Serial.println("*TH: MQTT Not connected.");
-        return false;
-      }
+  mqtt_subscribed = hash;
+  return true;
 }
 
 #ifdef __USE_WIFI_MANAGER__
@@ -827,8 +1933,8 @@ void THiNX::restore_device_info() {
 #ifndef __USE_SPIFFS__
 
   int value;
-  long buf_len = 512;
-  uint8_t info[512] = {0};
+  long buf_len = THINX_EEPROM_INFO_SIZE;
+  char info[THINX_EEPROM_INFO_SIZE + 1] = {0}; // parsed in place, always terminated
   long data_len = 0;
 
   Serial.println("*TH: restoring configuration from EEPROM...");
@@ -874,12 +1980,7 @@ void THiNX::restore_device_info() {
     Serial.println("*TH: JSON seems valid...");
   }
 
-  Serial.println("*TH: NOT Converting data to string...");  // flush may crash
-  //Serial.println((char*)info);
-
-  String data = ""; // String((char*)info); // + String("\n"); // LAST ADDED LINE, CRASHES
-  // data = String(info); // crashed with \n (?) // LAST ADDED LINE, CRASHES
-  //Serial.println(data)
+  char * json = info; // no String copy, see LoadStoreAlignmentCause notes
 
 #else
   if (!SPIFFS.exists("/thx.cfg")) {
@@ -897,6 +1998,7 @@ void THiNX::restore_device_info() {
        return;
    }
    String data = f.readStringUntil('\n');
+   char * json = thinx_json_buffer(data);
 #endif
 
    //Serial.println(data);
@@ -907,46 +2009,50 @@ void THiNX::restore_device_info() {
    //Serial.println(data); Serial.flush();
 
    Serial.print("*TH: Parsing...");
-   JsonObject& config = jsonBuffer.parseObject(data.c_str()); // must not be String!
+   StaticJsonBufferBase::Scope scope(jsonBuffer);
+   JsonObject& config = jsonBuffer.parseObject(json); // in place, must not be String!
    if (!config.success()) {
      Serial.println("*TH: Parsing JSON data failed...");
      save_device_info(); // Only sometimes causes crash,
-     Serial.println("*TH: Fixed data storage, re-reading...");
-     restore_device_info();
+     Serial.println("*TH: Fixed data storage with current values.");
      return;
    } else {
 
-     Serial.print("*TH: Reading JSON values...");
+     Serial.print("*TH: Reading JSON values..."); // absent keys are NULL
      const char* alias = config["alias"];
-     if (strlen(alias) > 1) {
+     if ((alias != NULL) && (strlen(alias) > 1)) {
        thinx_alias = strdup(alias);
        Serial.print("alias: ");
        Serial.println(alias);
      }
      const char* owner = config["owner"];
-     if (strlen(owner) > 4) {
+     if ((owner != NULL) && (strlen(owner) > 4)) {
        thinx_owner = strdup(owner);
        Serial.print("owner: ");
        Serial.println(owner);
      }
      const char* apikey = config["apikey"];
-     if (strlen(apikey) > 8) {
+     if ((apikey != NULL) && (strlen(apikey) > 8)) {
       thinx_api_key = strdup(apikey);
       Serial.print("apikey: ");
       Serial.println(apikey);
      }
      const char* update = config["update"];
-     if (strlen(update) > 4) {
+     if ((update != NULL) && (strlen(update) > 4)) {
        available_update_url = strdup(update);
        Serial.print("available_update_url: ");
        Serial.println(available_update_url);
      }
      const char* udid = config["udid"];
-     if (strlen(udid) > 4) {
+     if ((udid != NULL) && (strlen(udid) > 4)) {
       thinx_udid = strdup(udid);
      } else {
       thinx_udid = strdup(THINX_UDID);
      }
+     const char* hash = config["hash"];
+     if ((hash != NULL) && (strlen(hash) == 8)) {
+       checkin_hash_acked = strtoul(hash, NULL, 16);
+     }
      //Serial.print("udid: ");
      //Serial.println(udid); Serial.flush(); may cause crash
 #ifdef __USE_SPIFFS__
@@ -975,6 +2081,19 @@ void THiNX::restore_device_info() {
      delay(1);
    }
 #else
+  // Unchanged data is not rewritten, saves flash wear
+  bool same = true;
+  for (long addr = 0; addr <= info.length(); addr++) {
+    if (EEPROM.read(addr) != (uint8_t) info.charAt(addr)) {
+      same = false;
+      break;
+    }
+  }
+  if (same) {
+    Serial.println("*TH: EEPROM data unchanged.");
+    return;
+  }
+
   Serial.println("*TH: saving configuration to EEPROM: ");
   Serial.println(info); Serial.flush();
   for (long addr = 0; addr <= info.length(); addr++) {
@@ -990,6 +2109,7 @@ String THiNX::deviceInfo() {
 
   Serial.println("*TH: building device info:");
 
+  StaticJsonBufferBase::Scope scope(jsonBuffer);
   JsonObject& root = jsonBuffer.createObject();
 
   if (strlen(thinx_alias) > 0) {
@@ -1022,6 +2142,12 @@ String THiNX::deviceInfo() {
         Serial.println(available_update_url);
     }
 
+  char hash[9];
+  if (checkin_hash_acked != 0) {
+    sprintf(hash, "%08x", checkin_hash_acked);
+    root["hash"] = hash; // registration state last accepted by API
+  }
+
   String jsonString;
   root.printTo(jsonString);
 
@@ -1050,12 +2176,12 @@ void THiNX::update_and_reboot(String url) {
     mqtt_client->publish(MQTT::Publish(pub.topic(), "").set_retain());
     mqtt_client->disconnect();
 
-    Serial.printf("Update Success: %u\nRebooting...\n", millis() - startTime);
+    Serial.printf("Update Success: %lu\nRebooting...\n", millis() - startTime);
 
     // Notify on reboot for update
     if (mqtt_client) {
       mqtt_client->publish(
-        mqtt_device_status_channel,
+        topics.ref(THiNXTopics::STATUS),
         thx_reboot_response.c_str()
       );
       mqtt_client->disconnect();
@@ -1175,17 +2301,43 @@ void THiNX::loop() {
 
   //Serial.println("*TH: LOOP »");
 
+  // Never stay awake longer than allowed, even when WiFi or MQTT fails
+  if ((duty_cycle_seconds > 0) && (millis() > THINX_DUTY_CYCLE_TIMEOUT)) {
+    Serial.println("*TH: Wake timeout.");
+    deep_sleep();
+    return;
+  }
+
   // If not connected, start connection in progress...
   if (WiFi.status() == WL_CONNECTED) {
+    if (!connected || wifi_connection_in_progress) {
+      wifi_backoff.success();
+#ifdef __USE_WIFI_FAST_CONNECT__
+      wifi_fast_connect_in_progress = false;
+      wifi_cache_store(); // remember this association for the next boot
+#endif
+    }
     connected = true;
+    wifi_connection_in_progress = false;
   } else {
     connected = false;
     if (!wifi_connection_in_progress) {
+      if (!wifi_backoff.attempt(millis())) return;
       Serial.println("*TH: LOOP «÷»");
+      wifi_wait_start = millis();
       connect(); // blocking
       Serial.println("*TH: LOOP «");
       return;
     }
+#ifdef __USE_WIFI_FAST_CONNECT__
+    wifi_fast_connect_check();
+#endif
+    // Abandon this attempt, the next one is scheduled by backoff
+    if (millis() - wifi_wait_start > wifi_wait_timeout) {
+      Serial.println("*TH: WiFi connection attempt timed out.");
+      wifi_connection_in_progress = false;
+      wifi_backoff.failure(millis());
+    }
   }
 
   // If connected, perform the MQTT loop and bail out ASAP
@@ -1198,10 +2350,51 @@ void THiNX::loop() {
     if (WiFi.getMode() == WIFI_AP) return;
 
     if (mqtt_client) {
+      if (mqtt_result && !mqtt_client->connected()) {
+        Serial.println("*TH: MQTT connection lost.");
+        mqtt_result = false;
+        mqtt_backoff.failure(millis()); // do not reconnect in lockstep with the fleet
+      }
       mqtt_client->loop();
     }
+    apply_identity(); // changed by a message, the dispatcher is idle now
 
-    if (all_done) return;
+    // Initial and periodic check-ins as scheduled, failures retried with backoff
+    if (checkin_is_due() && (strlen(thinx_api_key) > 4)) {
+      if (api_backoff.attempt(millis())) {
+        Serial.println("*TH: WiFi connected, checking in...");
+        checked_in = true;
+        if (checkin()) { // blocking
+          api_backoff.success();
+          checkin_schedule_next();
+        } else {
+          api_backoff.failure(millis());
+        }
+        delay(1);
+        return; // finalize OR init MQTT in next loop
+      }
+    }
+
+    if (all_done) {
+      if (!mqtt_result) {
+        mqtt_reconnect();
+      }
+      if (mqtt_result && telemetry.due(millis())) {
+        publish_telemetry();
+      }
+      rpc_expire();
+      if (mqtt_result) {
+        shadow_sync();
+      }
+      if (update_approved) {
+        update_approved = false;
+        update_and_reboot(available_update_url); // after the approval was answered
+      }
+      if (duty_cycle_seconds > 0) {
+        duty_cycle();
+      }
+      return;
+    }
 
     /*
 
@@ -1225,7 +2418,7 @@ void THiNX::loop() {
           Serial.println("*TH: MQTT Publishing device status... ");
           // Publish status on status channel
           mqtt_client->publish(
-            mqtt_device_status_channel,
+            topics.ref(THiNXTopics::STATUS),
             "{ \"status\" : \"connected\" }"
           );
           finalize();
@@ -1233,31 +2426,17 @@ void THiNX::loop() {
       }
     }  */
 
-    // TODO: FIXME: After checked in, connect MQTT
-    if ( connected && checked_in ) {
+    // After checked in (or with identity already known), connect MQTT
+    if ( connected && (checked_in || (strlen(thinx_udid) > 4)) ) {
       Serial.println("*TH: WiFi connected, starting MQTT..."); Serial.flush();
       if (!mqtt_result) {
         delay(1);
-        mqtt_result = start_mqtt(); // connect only, do not subscribe
-        if (mqtt_result) {
+        if (mqtt_reconnect()) { // connect only, do not subscribe
           finalize();
         }
       }
     }
 
-    // If connected and not checked_in, perform check in.
-    if (connected && !checked_in) {
-      Serial.println("*TH: Will perform check in....");
-      if (strlen(thinx_api_key) > 4) {
-        Serial.println("*TH: WiFi connected, checking in...");
-        checked_in = true;
-        checkin(); // blocking
-        delay(1);
-        //finalize();
-        return; // finalize OR init MQTT in next loop
-      }
-    }
-
     // Save API key on change
     if (should_save_config) {
       Serial.println("*TH: Saving API key on change...");
@@ -1280,4 +2459,137 @@ void THiNX::finalize() {
   }
 }
 
+/*
+ * Duty-cycle
+ */
+
+void THiNX::setDutyCycle(unsigned long seconds) {
+  duty_cycle_seconds = seconds;
+}
+
+void THiNX::setDutyCycleCallback( void (*func)(JsonObject&) ) {
+  _duty_cycle_callback = func;
+}
+
+// Restores registration only after a deep-sleep wake, normal resets re-register
+bool THiNX::session_restore() {
+
+  if (ESP.getResetInfoPtr()->reason != REASON_DEEP_SLEEP_AWAKE) {
+    return false;
+  }
+
+  thinx_session_t session;
+  if (!ESP.rtcUserMemoryRead(THINX_RTC_SESSION, (uint32_t*) &session, sizeof(session))) {
+    return false;
+  }
+
+  if (session.crc != crc32(&session.wake_count, sizeof(session) - sizeof(session.crc))) {
+    return false;
+  }
+
+  session_wake_count = session.wake_count + 1;
+  if (session_wake_count >= THINX_DUTY_CYCLE_CHECKIN) {
+    Serial.println("*TH: Periodic check-in due.");
+    session_wake_count = 0;
+    return false;
+  }
+
+  thinx_udid = strdup(session.udid);
+  thinx_owner = strdup(session.owner);
+  thinx_alias = strdup(session.alias);
+  thinx_api_key = strdup(session.api_key);
+  checkin_hash_acked = session.checkin_hash;
+  mqtt_subscribed = session.mqtt_subscribed;
+  mqtt_packet_id = session.mqtt_packet_id;
+  mqtt_ping_interval = session.mqtt_ping_interval;
+#ifdef __USE_MSGPACK__
+  checkin_msgpack = session.msgpack;
+#endif
+
+  return true;
+}
+
+void THiNX::session_store() {
+
+  thinx_session_t session;
+  memset(&session, 0, sizeof(session));
+
+  // Values that do not fit are not cached; next wake takes the full path.
+  if ( (strlen(thinx_udid) < sizeof(session.udid)) &&
+       (strlen(thinx_owner) < sizeof(session.owner)) &&
+       (strlen(thinx_alias) < sizeof(session.alias)) &&
+       (strlen(thinx_api_key) < sizeof(session.api_key)) &&
+       (strlen(thinx_udid) > 4) ) {
+    session.wake_count = session_wake_count;
+    strcpy(session.udid, thinx_udid);
+    strcpy(session.owner, thinx_owner);
+    strcpy(session.alias, thinx_alias);
+    strcpy(session.api_key, thinx_api_key);
+    session.checkin_hash = checkin_hash_acked;
+    session.mqtt_subscribed = mqtt_subscribed;
+    session.mqtt_packet_id = (mqtt_client != NULL) ? mqtt_client->next_packet_id() : mqtt_packet_id;
+    session.mqtt_ping_interval = (mqtt_client != NULL) ? mqtt_client->ping_stats().interval : mqtt_ping_interval;
+#ifdef __USE_MSGPACK__
+    session.msgpack = checkin_msgpack;
+#endif
+    session.crc = crc32(&session.wake_count, sizeof(session) - sizeof(session.crc));
+  }
+
+  ESP.rtcUserMemoryWrite(THINX_RTC_SESSION, (uint32_t*) &session, sizeof(session));
+}
+
+// Called from loop once MQTT is up: publish a single frame, listen, sleep.
+void THiNX::duty_cycle() {
+
+  if (!duty_cycle_frame_sent) {
+
+    duty_cycle_frame_sent = true;
+    duty_cycle_listen_start = millis();
+
+    if ((mqtt_client == NULL) || !mqtt_client->connected()) return;
+
+    publish_telemetry(); // samples recorded since wake, no need to wait for a full batch
+
+    StaticJsonBufferBase::Scope scope(jsonBuffer);
+    JsonObject& frame = jsonBuffer.createObject();
+    frame["status"] = "connected";
+    frame["wake"] = session_wake_count;
+    frame["uptime"] = millis();
+    json_stats(frame);
+    if (_duty_cycle_callback) {
+      _duty_cycle_callback(frame); // application telemetry
+    }
+
+#ifdef __USE_MSGPACK__
+    if (publish_msgpack(THiNXTopics::STATUS_MSGPACK, frame)) return;
+#endif
+
+    publish_json(THiNXTopics::STATUS, frame);
+    return;
+  }
+
+  // Let mqtt_client->loop() deliver pending commands for a moment
+  if (millis() - duty_cycle_listen_start < THINX_DUTY_CYCLE_LISTEN) return;
+
+  deep_sleep();
+}
+
+void THiNX::deep_sleep() {
+
+  session_store();
+#ifdef __USE_SPIFFS__
+  telemetry_clock_store();
+#endif
+
+  if ((mqtt_client != NULL) && mqtt_client->connected()) {
+    mqtt_client->disconnect(); // clean disconnect, no will message
+  }
+
+  Serial.print("*TH: Awake for "); Serial.print(millis());
+  Serial.print(" ms, sleeping "); Serial.print(duty_cycle_seconds); Serial.println(" s...");
+  Serial.flush();
+
+  ESP.deepSleep(duty_cycle_seconds * 1000000ULL);
+}
+
 #endif    // IMPORTANT LINE!
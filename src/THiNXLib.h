@@ -9,6 +9,8 @@
 
 //#define __USE_WIFI_MANAGER__
 //#define __USE_SPIFFS__
+#define __USE_WIFI_FAST_CONNECT__ // reconnect to last known BSSID/channel/IP first
+//#define __USE_MSGPACK__ // MessagePack check-in body and status frames (falls back to JSON on 415)
 
 #ifdef __USE_WIFI_MANAGER__
 #include <WiFiManager.h>
@@ -29,8 +31,286 @@
 #include "PubSubClient/PubSubClient.h" // Local checkout
 //#include <PubSubClient.h> // Arduino Library
 
+#include "THiNXTopics.h"
+#include "THiNXBackoff.h"
+#include "THiNXMsgPack.h"
+#include "THiNXLZSS.h"
+#include "THiNXBufferedPrint.h"
+#include "THiNXTelemetry.h"
+#include "THiNXDispatcher.h"
+#include "THiNXRPC.h"
+#include "THiNXShadow.h"
+#include "THiNXBinding.h"
+#include <StreamString.h>
+
 #define MQTT_BUFFER_SIZE 512
 
+// RTC user memory layout (offsets in 4-byte blocks, 128 blocks available)
+#define THINX_RTC_WIFI_CACHE 0
+#define THINX_RTC_SESSION 8
+#define THINX_RTC_CLOCK 72
+
+// Fast-connect attempt is abandoned after this many ms (falls back to DHCP)
+#ifndef THINX_FAST_CONNECT_TIMEOUT
+#define THINX_FAST_CONNECT_TIMEOUT 3000
+#endif
+
+// Last good WiFi association, kept in RTC memory across reboots and deep sleep
+typedef struct {
+  uint32_t crc;                             // CRC32 of all following fields
+  uint32_t ssid_crc;                        // network this lease belongs to
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t netmask;
+  uint32_t dns;
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t reserved;
+} thinx_wifi_cache_t;
+
+// WiFi connection attempt is abandoned after this many ms and retried with backoff
+#ifndef THINX_WIFI_CONNECT_TIMEOUT
+#define THINX_WIFI_CONNECT_TIMEOUT 20000
+#endif
+
+// Reconnect backoff per service: base delay, cap (ms), attempts per hour
+#ifndef THINX_BACKOFF_WIFI
+#define THINX_BACKOFF_WIFI 2000, 120000, 60
+#endif
+
+#ifndef THINX_BACKOFF_API
+#define THINX_BACKOFF_API 5000, 600000, 12
+#endif
+
+#ifndef THINX_BACKOFF_MQTT
+#define THINX_BACKOFF_MQTT 2000, 300000, 30
+#endif
+
+// Duty-cycle: time to listen for pending commands before going back to sleep
+#ifndef THINX_DUTY_CYCLE_LISTEN
+#define THINX_DUTY_CYCLE_LISTEN 500
+#endif
+
+// Duty-cycle: hard limit for a single wake, sleeps even when not done (ms)
+#ifndef THINX_DUTY_CYCLE_TIMEOUT
+#define THINX_DUTY_CYCLE_TIMEOUT 15000
+#endif
+
+// Duty-cycle: perform full API check-in every n-th wake to pick up changes
+#ifndef THINX_DUTY_CYCLE_CHECKIN
+#define THINX_DUTY_CYCLE_CHECKIN 24
+#endif
+
+// Flash tier for telemetry buckets (with __USE_SPIFFS__), 20 bytes per bucket
+#ifndef THINX_TELEMETRY_FLASH_BUCKETS
+#define THINX_TELEMETRY_FLASH_BUCKETS 1024
+#endif
+
+#define THINX_TELEMETRY_FILE "/thx_ts.bin"
+
+// Flash tier records with count 0 are headers, their channel tells which
+#define THINX_SPILL_WAKE 0                  // start holds the device clock at millis() 0 of the wake
+#define THINX_SPILL_POWER_ON 1              // the clock restarted, earlier records have no common time
+
+// Device clock carried across deep sleep, so that spilled buckets of earlier
+// wakes can be placed against this one; a reset or power loss restarts it
+typedef struct {
+  uint32_t crc;                             // CRC32 of all following fields
+  uint32_t base;                            // ms on the device clock at millis() 0 of this wake
+  uint32_t unmarked;                        // restart not yet recorded in the flash tier
+} thinx_clock_t;
+
+// Keep broker session (subscriptions, queued QoS 1 messages) across reconnects
+#ifndef THINX_MQTT_PERSISTENT_SESSION
+#define THINX_MQTT_PERSISTENT_SESSION true
+#endif
+
+// Subscription QoS; the broker queues messages for an absent device only at QoS > 0
+#ifndef THINX_MQTT_QOS
+#define THINX_MQTT_QOS 1
+#endif
+
+// CONNECT keepalive (seconds), upper bound of the ping interval and broker-side timeout
+#ifndef THINX_MQTT_KEEPALIVE
+#define THINX_MQTT_KEEPALIVE 300
+#endif
+
+// Shortest adaptive ping interval (seconds), also the initial one
+#ifndef THINX_MQTT_PING_MIN
+#define THINX_MQTT_PING_MIN 30
+#endif
+
+// Arena for check-in, response parsing and device info, released after each use
+#ifndef THINX_JSON_BUFFER_SIZE
+#define THINX_JSON_BUFFER_SIZE 1024
+#endif
+
+// Per-message JSON buffers (RPC, shadow) take fixed blocks from a static pool
+// instead of the heap; larger documents fall back to malloc
+#ifndef THINX_JSON_POOL_BLOCK
+#define THINX_JSON_POOL_BLOCK 384
+#endif
+
+#ifndef THINX_JSON_POOL_BLOCKS
+#define THINX_JSON_POOL_BLOCKS 4
+#endif
+
+typedef DynamicJsonBufferBase<StaticPoolAllocator<THINX_JSON_POOL_BLOCK, THINX_JSON_POOL_BLOCKS> > thinx_json_pool_t;
+
+class THiNXJsonBuffer : public thinx_json_pool_t {
+  public:
+    THiNXJsonBuffer() : thinx_json_pool_t(THINX_JSON_POOL_BLOCK - thinx_json_pool_t::blockOverhead, 1) {
+#if ARDUINOJSON_PARSE_NUMBERS
+      convertNumbers(true);
+#endif
+    }
+#if ARDUINOJSON_ENABLE_STATS
+    ~THiNXJsonBuffer() { totals().merge(stats()); }
+
+    // Usage of all per-message buffers released so far
+    static JsonBufferStats & totals() {
+      static JsonBufferStats all;             // zero-initialized
+      return all;
+    }
+#endif
+};
+
+// EEPROM: device info JSON, followed by shadow field slots
+#ifndef THINX_EEPROM_INFO_SIZE
+#define THINX_EEPROM_INFO_SIZE 512
+#endif
+
+#ifndef THINX_SHADOW_EEPROM_SIZE
+#define THINX_SHADOW_EEPROM_SIZE 512
+#endif
+
+// How often bound shadow variables are checked for local changes (ms)
+#ifndef THINX_SHADOW_SCAN
+#define THINX_SHADOW_SCAN 1000
+#endif
+
+// Application commands routed from /owner/udid/command/<name>
+#ifndef THINX_COMMANDS
+#define THINX_COMMANDS 8
+#endif
+
+// Device, update, notification, RPC, shadow, reboot and config are routed too
+#if THINX_DISPATCH_HANDLERS < THINX_COMMANDS + 7
+#error "THINX_DISPATCH_HANDLERS must hold THINX_COMMANDS and the 7 built-in routes"
+#endif
+
+// MQTT payloads shorter than this are never compressed
+#ifndef THINX_COMPRESS_THRESHOLD
+#define THINX_COMPRESS_THRESHOLD 128
+#endif
+
+// Registration strings incl. terminator; one set of sizes for the RTC session,
+// the envelope bindings, the shadow slots and the topic prefix
+#define THINX_ALIAS_SIZE 32
+#define THINX_OWNER_SIZE 68
+#define THINX_UDID_SIZE 64
+#define THINX_API_KEY_SIZE 68
+
+#if THINX_TOPIC_PREFIX_SIZE < THINX_OWNER_SIZE + THINX_UDID_SIZE + 1
+#error THINX_TOPIC_PREFIX_SIZE cannot hold "/owner/udid"
+#endif
+
+// Registration results kept in RTC memory, so deep-sleep wakes may skip
+// both the HTTP check-in and the EEPROM/JSON restore
+typedef struct {
+  uint32_t crc;                             // CRC32 of all following fields
+  uint32_t wake_count;                      // wakes since last full check-in
+  char udid[THINX_UDID_SIZE];
+  char owner[THINX_OWNER_SIZE];
+  char alias[THINX_ALIAS_SIZE];
+  char api_key[THINX_API_KEY_SIZE];
+  uint32_t checkin_hash;                    // registration state acknowledged by API
+  uint32_t mqtt_subscribed;                 // hash of filters the broker session holds
+  uint16_t mqtt_packet_id;                  // next MQTT packet id of the session
+  uint16_t mqtt_ping_interval;              // learned idle time the link survives (seconds)
+  bool msgpack;                             // API takes MessagePack (__USE_MSGPACK__)
+} thinx_session_t;
+
+// Firmware URL kept for a pending update (with terminator); OTT URLs carry
+// a token, longer ones are rejected. Also a shadow slot, mind the EEPROM size.
+#ifndef THINX_UPDATE_URL_SIZE
+#define THINX_UPDATE_URL_SIZE 257
+#endif
+
+// API and MQTT envelopes, decoded straight from the message text by THiNXBinding
+typedef struct {
+  bool success;
+  char status[20];                          // OK or FIRMWARE_UPDATE
+  char alias[THINX_ALIAS_SIZE];
+  char owner[THINX_OWNER_SIZE];
+  char udid[THINX_UDID_SIZE];
+  long checkin_interval;                    // optional schedule hints
+  long checkin_slot;
+  char encoding[12];                        // lzss when MQTT frames may be compressed
+  char mac[18];                             // FIRMWARE_UPDATE only
+  char commit[41];
+  char version[81];
+  char url[THINX_UPDATE_URL_SIZE];
+} thinx_registration_t;
+
+THINX_BINDING(thinx_registration_t,
+  THINX_FIELD(thinx_registration_t, success),
+  THINX_FIELD(thinx_registration_t, status),
+  THINX_FIELD(thinx_registration_t, alias),
+  THINX_FIELD(thinx_registration_t, owner),
+  THINX_FIELD(thinx_registration_t, udid),
+  THINX_FIELD(thinx_registration_t, checkin_interval),
+  THINX_FIELD(thinx_registration_t, checkin_slot),
+  THINX_FIELD(thinx_registration_t, encoding),
+  THINX_FIELD(thinx_registration_t, mac),
+  THINX_FIELD(thinx_registration_t, commit),
+  THINX_FIELD(thinx_registration_t, version),
+  THINX_FIELD(thinx_registration_t, url)
+);
+
+typedef struct {
+  char mac[18];
+  char commit[41];
+  char version[81];
+  char type[16];
+  char url[THINX_UPDATE_URL_SIZE];
+  char ott[THINX_UPDATE_URL_SIZE];          // one-time token URL, preferred over url
+} thinx_update_t;
+
+THINX_BINDING(thinx_update_t,
+  THINX_FIELD(thinx_update_t, mac),
+  THINX_FIELD(thinx_update_t, commit),
+  THINX_FIELD(thinx_update_t, version),
+  THINX_FIELD(thinx_update_t, type),
+  THINX_FIELD(thinx_update_t, url),
+  THINX_FIELD(thinx_update_t, ott)
+);
+
+typedef struct {
+  char response_type[8];                    // bool or string
+  char response[8];                         // true/false or yes/no
+} thinx_notification_t;
+
+THINX_BINDING(thinx_notification_t,
+  THINX_FIELD(thinx_notification_t, response_type),
+  THINX_FIELD(thinx_notification_t, response)
+);
+
+// Question for the user, answered with a notification
+typedef struct {
+  char title[20];
+  char body[96];
+  char type[12];
+  char response_type[8];
+} thinx_prompt_t;
+
+THINX_BINDING(thinx_prompt_t,
+  THINX_FIELD(thinx_prompt_t, title),
+  THINX_FIELD(thinx_prompt_t, body),
+  THINX_FIELD(thinx_prompt_t, type),
+  THINX_FIELD(thinx_prompt_t, response_type)
+);
+
 #ifdef THINX_FIRMWARE_VERSION_SHORT
 #ifndef THX_REVISION
 #define THX_REVISION THINX_FIRMWARE_VERSION_SHORT
@@ -55,6 +335,8 @@ class THiNX {
 
     THiNX();
     THiNX(const char *);
+    void init(const char *);                // API Key; once, from setup()
+    THiNX & operator=(const THiNX &);       // DEPRECATED: `thx = THiNX(apikey)` re-runs init(), use thx.init(apikey)
 
     enum payload_type {
       Unknown = 0,
@@ -69,6 +351,30 @@ class THiNX {
     void publish();
     void loop();
 
+    // Telemetry: register channels and record samples, batches are sent from loop()
+    THiNXTelemetry telemetry;
+    bool publish_telemetry();               // send queued samples now
+
+#if ARDUINOJSON_ENABLE_STATS
+    // JSON buffer usage (build with -DARDUINOJSON_ENABLE_STATS=1), also sent
+    // with the status and in diagnostics, to right-size the buffers
+    const JsonBufferStats & json_arena_stats() const { return jsonBuffer.stats(); }
+    const JsonBufferStats & json_pool_stats() const { return THiNXJsonBuffer::totals(); }
+#endif
+
+    // Commands: handler for messages on /owner/udid/command/<command> (+ and # allowed)
+    bool setCommandCallback(const char * command, thinx_handler_t func, void * context = NULL);
+
+    // Shadow: bind more fields with thx.shadow.field(...) after construction
+    THiNXShadow shadow;
+
+    // RPC: serve methods on /owner/udid/rpc, answer and call over /owner/udid/rpc/out
+    bool setMethodCallback(const char * method, THiNXRPC::method_t func, void * context = NULL);
+    bool respond(const char * id, JsonObject & result); // completes a method that returned PENDING
+    bool respondError(const char * id, const char * error);
+    const char * call(const char * method, JsonObject & params, THiNXRPC::reply_t reply,
+                      void * context = NULL, unsigned long timeout = THINX_RPC_TIMEOUT); // returns id or NULL
+
     String checkin_body();                  // TODO: Refactor to C-string
 
     // MQTT
@@ -76,14 +382,13 @@ class THiNX {
 
     uint8_t buf[MQTT_BUFFER_SIZE];
 
-    String thinx_mqtt_channel();
-    char mqtt_device_channel[128]; //  = {0}
-    String thinx_mqtt_status_channel();
-    char mqtt_device_status_channel[128]; //  = {0}
+    THiNXTopics topics;                     // device topics, rebuilt on owner/udid change
+    String thinx_mqtt_channel();            // DEPRECATED: use topics.name(THiNXTopics::DEVICE)
+    String thinx_mqtt_status_channel();     // DEPRECATED: use topics.name(THiNXTopics::STATUS)
 
     // Import build-time values from thinx.h
     const char* app_version;                  // max 80 bytes
-    const char* available_update_url;         // up to 1k
+    const char* available_update_url;         // shorter than THINX_UPDATE_URL_SIZE
     const char* thinx_cloud_url;              // up to 1k but generally something where FQDN fits
     const char* thinx_commit_id;              // 40 bytes + 1
     const char* thinx_firmware_version_short; // 14 bytes
@@ -107,6 +412,10 @@ class THiNX {
 
     void setFinalizeCallback( void (*func)(void) );
 
+    // Deep-sleep duty-cycle mode: wake, connect, publish one frame, sleep
+    void setDutyCycle(unsigned long);       // sleep interval in seconds, 0 disables
+    void setDutyCycleCallback( void (*func)(JsonObject&) ); // adds telemetry to the frame
+
 #ifdef __USE_WIFI_MANAGER__
     WiFiManager *manager;
     WiFiManagerParameter *api_key_param;
@@ -121,6 +430,8 @@ class THiNX {
 
     private:
 
+      THiNX(const THiNX &);                   // non-copyable, callbacks are bound to this
+
       void configCallback();
 
       // WiFi Manager
@@ -134,24 +445,92 @@ class THiNX {
       char mac_string[16] = {0};
       const char * thinx_mac();
 
-      StaticJsonBuffer<1024> jsonBuffer;
-      StaticJsonBuffer<1280> wrapperBuffer;
+      StaticJsonBuffer<THINX_JSON_BUFFER_SIZE> jsonBuffer; // shared arena, every use is scoped
 
       // In order of appearance
       bool fsck();                            // check filesystem if using SPIFFS
       void connect();                         // start the connect loop
       void connect_wifi();                    // start connecting
-      void checkin();                         // checkin when connected
-      void senddata(String);                  // TODO: Refactor to C-string
+      bool checkin();                         // checkin when connected
+      bool senddata(String);                  // TODO: Refactor to C-string
+      bool senddata(const uint8_t *, size_t, const char *); // body, length, content type
+      bool api_request(size_t, const char *); // connects and sends headers; body length, content type
+      bool api_response();                    // waits for, reads and parses the API reply
+      JsonObject& checkin_object();           // registration wrapper for JSON or MessagePack
+#ifdef __USE_MSGPACK__
+      bool checkin_msgpack;                   // cleared when API answers 415, gates status/msgpack too
+#endif
       void parse(String);                     // TODO: Refactor to C-string
       void update_and_reboot(String);         // TODO: Refactor to C-string
 
       // MQTT
       bool start_mqtt();                      // connect to broker and subscribe
+      void update_topics();                   // rebuild topic table from owner/udid
+      void update_identity();                 // owner/udid changed, applied outside dispatch
+      void apply_identity();                  // topics, routes and broker session follow
+      bool identity_pending;
+      void update_routes();                   // rebuild dispatcher trie from topics
+      void mqtt_callback(const MQTT::Publish &);
+      THiNXDispatcher dispatcher;
+      struct {
+        const char * name;
+        thinx_handler_t func;
+        void * context;
+      } commands[THINX_COMMANDS];
+      uint8_t commands_count;
+      bool add_command_route(const char *, thinx_handler_t, void *);
+      static void on_envelope(const char *, const uint8_t *, size_t, void *);
+      static void on_reboot(const char *, const uint8_t *, size_t, void *);
+      static void on_config(const char *, const uint8_t *, size_t, void *);
+
+      // RPC
+      THiNXRPC rpc;
+      bool update_approved;                   // install available_update_url from loop
+      bool rpc_publish(const char * id, JsonObject * result, const char * error);
+      void rpc_expire();
+      static void on_rpc(const char *, const uint8_t *, size_t, void *);
+      static THiNXRPC::status_t method_config_read(const char *, JsonObject &, JsonObject &, void *);
+      static THiNXRPC::status_t method_diagnostics(const char *, JsonObject &, JsonObject &, void *);
+      static THiNXRPC::status_t method_update_approve(const char *, JsonObject &, JsonObject &, void *);
+      void rpc_methods();                     // registers built-in methods
+
+      // Device shadow
+      unsigned long shadow_last_scan;
+      void shadow_begin();                    // binds built-in fields, restores their slots
+      void shadow_sync();
+      static void on_shadow(const char *, const uint8_t *, size_t, void *);
+      static void on_shadow_change(const char *, void *);
+
       bool mqtt_result;                       // success or failure on connection
       bool mqtt_connected;                    // success or failure on subscription
       String mqtt_payload;                    // mqtt_payload store for parsing
-      int last_mqtt_reconnect;                // interval
+      bool mqtt_reconnect();                  // start_mqtt() when allowed by backoff
+      bool mqtt_compress;                     // server accepts LZSS frames (registration hint)
+      bool mqtt_subscribe();                  // all device filters in one SUBSCRIBE
+      uint32_t mqtt_subscribed;               // hash of filters held by the broker session
+      bool mqtt_clean_session;                // next CONNECT drops the session (identity changed)
+      uint16_t mqtt_packet_id;                // restored session packet id
+      uint16_t mqtt_ping_interval;            // restored adaptive ping interval
+      bool publish_payload(THiNXTopics::topic_id, const uint8_t *, size_t);
+      bool publish_json(THiNXTopics::topic_id, JsonObject &); // serialized once, into the packet
+      void publish_status();                  // "connected", with JSON buffer usage when counted
+      void json_stats(JsonObject &);          // adds JSON buffer usage, if counted
+      bool publish_buffer(THiNXTopics::topic_id, MQTT::PacketBuffer &);
+#ifdef __USE_MSGPACK__
+      bool publish_msgpack(THiNXTopics::topic_id, JsonObject &); // while checkin_msgpack
+#endif
+#ifdef __USE_SPIFFS__
+      static bool telemetry_spill(const thinx_bucket_t &); // flash tier for offline buckets
+      bool telemetry_drain();
+      bool telemetry_drain_chunk(const thinx_bucket_t *, size_t, uint16_t);
+      void telemetry_clock_restore();
+      void telemetry_clock_store();
+#endif
+
+      // Reconnect scheduling
+      THiNXBackoff wifi_backoff;
+      THiNXBackoff api_backoff;
+      THiNXBackoff mqtt_backoff;
       bool perform_mqtt_checkin;              // one-time flag
       bool all_done;                              // finalize flag
 
@@ -166,7 +545,20 @@ class THiNX {
       void notify_on_successful_update();     // send a MQTT notification back to Web UI
 
       // Event Queue / States
-      bool checked_in;
+      bool checked_in;                        // check-in attempted, MQTT may start
+
+      // Check-in schedule
+      bool checkin_pending;                   // check-in should run at checkin_due
+      unsigned long checkin_due;
+      long checkin_interval;                  // seconds, may be overridden by server
+      long checkin_slot;                      // seconds until next check-in, one-shot server hint
+      uint32_t checkin_hash;                  // hash of registration state being sent
+      uint32_t checkin_hash_acked;            // hash last accepted by API (like an ETag)
+      bool checkin_conditional;               // compact body + If-None-Match
+      uint32_t registration_hash();
+      void checkin_schedule_initial();
+      void checkin_schedule_next();
+      bool checkin_is_due();
       bool mqtt_started;
       bool wifi_connection_in_progress;
       bool complete;
@@ -176,10 +568,32 @@ class THiNX {
       void (*_finalize_callback)(void) = NULL;
       void finalize();                        // Complete the checkin, schedule, callback...
 
+      // Duty-cycle
+      unsigned long duty_cycle_seconds;       // 0 = always-on loop
+      bool duty_cycle_frame_sent;
+      unsigned long duty_cycle_listen_start;
+      void (*_duty_cycle_callback)(JsonObject&) = NULL;
+      uint32_t session_wake_count;
+      bool session_restore();                 // reads registration from RTC after deep-sleep wake
+      void session_store();                   // writes registration to RTC before deep-sleep
+      void duty_cycle();                      // publish frame, listen, sleep
+      void deep_sleep();
+
       // Local WiFi Impl
       bool wifi_wait_for_connect;
       unsigned long wifi_wait_start;
       unsigned long wifi_wait_timeout;
       int wifi_retry;
       uint8_t wifi_status;
+
+      // WiFi Fast Connect
+      static uint32_t crc32(const void *, size_t, uint32_t seed = 0);
+#ifdef __USE_WIFI_FAST_CONNECT__
+      bool wifi_fast_connect(const char *, const char *); // directed connect from RTC cache
+      void wifi_fast_connect_check();         // fall back to full connect on timeout
+      void wifi_cache_store();                // persist current association to RTC
+      void wifi_cache_invalidate();
+      bool wifi_fast_connect_in_progress;
+      unsigned long wifi_fast_connect_start;
+#endif
 };
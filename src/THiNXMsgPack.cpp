@@ -0,0 +1,138 @@
+#include "THiNXMsgPack.h"
+
+THiNXMsgPack::THiNXMsgPack(uint8_t * buffer, size_t capacity) :
+  _buffer(buffer), _capacity(capacity), _pos(0), _overflow(false)
+{}
+
+void THiNXMsgPack::byte(uint8_t b) {
+  if (_pos < _capacity) {
+    _buffer[_pos++] = b;
+  } else {
+    _overflow = true;
+  }
+}
+
+void THiNXMsgPack::be(uint32_t value, uint8_t bytes) {
+  while (bytes--) {
+    byte((value >> (8 * bytes)) & 0xFF);
+  }
+}
+
+void THiNXMsgPack::raw(const void * data, size_t length) {
+  if (_pos + length <= _capacity) {
+    memcpy(_buffer + _pos, data, length);
+    _pos += length;
+  } else {
+    _overflow = true;
+  }
+}
+
+void THiNXMsgPack::map(uint32_t count) {
+  if (count < 16) {
+    byte(0x80 | count);
+  } else if (count <= 0xFFFF) {
+    byte(0xDE); be(count, 2);
+  } else {
+    byte(0xDF); be(count, 4);
+  }
+}
+
+void THiNXMsgPack::array(uint32_t count) {
+  if (count < 16) {
+    byte(0x90 | count);
+  } else if (count <= 0xFFFF) {
+    byte(0xDC); be(count, 2);
+  } else {
+    byte(0xDD); be(count, 4);
+  }
+}
+
+void THiNXMsgPack::str(const char * value) {
+  str(value, strlen(value));
+}
+
+void THiNXMsgPack::str(const char * value, uint32_t length) {
+  if (length < 32) {
+    byte(0xA0 | length);
+  } else if (length <= 0xFF) {
+    byte(0xD9); be(length, 1);
+  } else if (length <= 0xFFFF) {
+    byte(0xDA); be(length, 2);
+  } else {
+    byte(0xDB); be(length, 4);
+  }
+  raw(value, length);
+}
+
+void THiNXMsgPack::uinteger(unsigned long value) {
+  if (value < 128) {
+    byte(value);                            // positive fixint
+  } else if (value <= 0xFF) {
+    byte(0xCC); be(value, 1);
+  } else if (value <= 0xFFFF) {
+    byte(0xCD); be(value, 2);
+  } else {
+    byte(0xCE); be(value, 4);
+  }
+}
+
+void THiNXMsgPack::integer(long value) {
+  if (value >= 0) {
+    uinteger(value);
+  } else if (value >= -32) {
+    byte(value & 0xFF);                     // negative fixint
+  } else if (value >= -128) {
+    byte(0xD0); be(value, 1);
+  } else if (value >= -32768) {
+    byte(0xD1); be(value, 2);
+  } else {
+    byte(0xD2); be(value, 4);
+  }
+}
+
+void THiNXMsgPack::number(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  byte(0xCA); be(bits, 4);
+}
+
+void THiNXMsgPack::boolean(bool value) {
+  byte(value ? 0xC3 : 0xC2);
+}
+
+void THiNXMsgPack::nil() {
+  byte(0xC0);
+}
+
+void THiNXMsgPack::value(const JsonObject & object) {
+  map(object.size());
+  for (JsonObject::const_iterator it = object.begin(); it != object.end(); ++it) {
+    str(it->key);
+    value(it->value);
+  }
+}
+
+void THiNXMsgPack::value(const JsonArray & items) {
+  array(items.size());
+  for (JsonArray::const_iterator it = items.begin(); it != items.end(); ++it) {
+    value(*it);
+  }
+}
+
+void THiNXMsgPack::value(const JsonVariant & variant) {
+  if (variant.is<JsonObject>()) {
+    value(variant.as<JsonObject>());
+  } else if (variant.is<JsonArray>()) {
+    value(variant.as<JsonArray>());
+  } else if (variant.is<bool>()) {
+    boolean(variant.as<bool>());
+  } else if (variant.is<long>()) {
+    integer(variant.as<long>());
+  } else if (variant.is<float>()) {
+    number(variant.as<float>());
+  } else if (variant.is<const char*>() && (variant.as<const char*>() != NULL)) {
+    str(variant.as<const char*>());
+  } else {
+    nil();
+  }
+}
@@ -0,0 +1,49 @@
+#ifndef THiNXMsgPack_h
+#define THiNXMsgPack_h
+
+#include <Arduino.h>
+
+#include "ArduinoJson/ArduinoJson.h"
+
+//! Streaming MessagePack encoder writing into a caller-provided buffer
+/*!
+  Encodes either explicit values (map/array headers followed by items) or a
+  whole ArduinoJson document through value(). On overflow all further writes
+  are ignored and overflowed() turns true, so callers check once at the end.
+*/
+class THiNXMsgPack {
+
+  public:
+
+    THiNXMsgPack(uint8_t * buffer, size_t capacity);
+
+    void map(uint32_t count);                 // followed by count key/value pairs
+    void array(uint32_t count);               // followed by count values
+    void str(const char * value);
+    void str(const char * value, uint32_t length);
+    void integer(long value);
+    void uinteger(unsigned long value);
+    void number(float value);
+    void boolean(bool value);
+    void nil();
+
+    //! Encodes a JSON value recursively (objects, arrays, strings, numbers...)
+    void value(const JsonVariant & variant);
+    void value(const JsonObject & object);
+    void value(const JsonArray & array);
+
+    size_t size() const { return _pos; }
+    bool overflowed() const { return _overflow; }
+
+  private:
+    void byte(uint8_t b);
+    void be(uint32_t value, uint8_t bytes); // big-endian
+    void raw(const void * data, size_t length);
+
+    uint8_t * _buffer;
+    size_t _capacity;
+    size_t _pos;
+    bool _overflow;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "THiNXRPC.h"
+
+THiNXRPC::THiNXRPC() :
+  _methods(0), _sequence(0)
+{
+  for (uint8_t i = 0; i < THINX_RPC_PENDING; i++) {
+    _call[i].used = false;
+  }
+  _expired[0] = 0;
+}
+
+bool THiNXRPC::method(const char * name, method_t func, void * context) {
+  for (uint8_t i = 0; i < _methods; i++) {
+    if (strcmp(_method[i].name, name) == 0) {
+      _method[i].func = func;
+      _method[i].context = context;
+      return true;
+    }
+  }
+  if (_methods >= THINX_RPC_METHODS) return false;
+  _method[_methods].name = name;
+  _method[_methods].func = func;
+  _method[_methods].context = context;
+  _methods++;
+  return true;
+}
+
+THiNXRPC::method_t THiNXRPC::find(const char * name, void ** context) const {
+  for (uint8_t i = 0; i < _methods; i++) {
+    if (strcmp(_method[i].name, name) == 0) {
+      *context = _method[i].context;
+      return _method[i].func;
+    }
+  }
+  return NULL;
+}
+
+int8_t THiNXRPC::lookup(const char * id, bool inbound) const {
+  for (uint8_t i = 0; i < THINX_RPC_PENDING; i++) {
+    if (_call[i].used && (_call[i].inbound == inbound) && (strcmp(_call[i].id, id) == 0)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool THiNXRPC::full() const {
+  for (uint8_t i = 0; i < THINX_RPC_PENDING; i++) {
+    if (!_call[i].used) return false;
+  }
+  return true;
+}
+
+bool THiNXRPC::begin(const char * id, bool inbound, unsigned long timeout, reply_t reply, void * context) {
+
+  if ((strlen(id) >= THINX_RPC_ID_SIZE) || (lookup(id, inbound) != -1)) return false;
+
+  for (uint8_t i = 0; i < THINX_RPC_PENDING; i++) {
+    call_t & call = _call[i];
+    if (call.used) continue;
+    strcpy(call.id, id);
+    call.started = millis();
+    call.timeout = timeout;
+    call.reply = reply;
+    call.context = context;
+    call.inbound = inbound;
+    call.used = true;
+    return true;
+  }
+  return false;
+}
+
+bool THiNXRPC::end(const char * id, bool inbound, reply_t * reply, void ** context) {
+  int8_t index = lookup(id, inbound);
+  if (index == -1) return false;
+  if (reply) *reply = _call[index].reply;
+  if (context) *context = _call[index].context;
+  _call[index].used = false;
+  return true;
+}
+
+const char * THiNXRPC::expire(unsigned long now, bool * inbound, reply_t * reply, void ** context) {
+  for (uint8_t i = 0; i < THINX_RPC_PENDING; i++) {
+    call_t & call = _call[i];
+    if (!call.used || (now - call.started < call.timeout)) continue;
+    strcpy(_expired, call.id);
+    *inbound = call.inbound;
+    *reply = call.reply;
+    *context = call.context;
+    call.used = false;
+    return _expired;
+  }
+  return NULL;
+}
+
+const char * THiNXRPC::next_id() {
+  snprintf(_next, sizeof(_next), "%08x-%u", ESP.getChipId(), ++_sequence);
+  return _next;
+}
@@ -0,0 +1,100 @@
+#ifndef THiNXRPC_h
+#define THiNXRPC_h
+
+#include <Arduino.h>
+
+#include "ArduinoJson/ArduinoJson.h"
+
+// Methods the device can serve
+#ifndef THINX_RPC_METHODS
+#define THINX_RPC_METHODS 8
+#endif
+
+// Calls in flight at once, both directions
+#ifndef THINX_RPC_PENDING
+#define THINX_RPC_PENDING 4
+#endif
+
+// Default time for a call to be answered (ms)
+#ifndef THINX_RPC_TIMEOUT
+#define THINX_RPC_TIMEOUT 30000UL
+#endif
+
+// Longest correlation id kept, incl. terminator
+#define THINX_RPC_ID_SIZE 24
+
+//! Method table and bounded pending-call table for request/response over MQTT
+/*!
+  Messages are JSON objects correlated by "id":
+
+    request   {"id":"7","method":"config.read","params":{...}}
+    response  {"id":"7","result":{...}}  or  {"id":"7","error":"timeout"}
+
+  A served method may answer at once or return PENDING and answer later;
+  calls the device makes are answered through a reply callback. Both kinds
+  occupy a pending slot until answered or timed out, so a slow operation
+  never blocks the others.
+*/
+class THiNXRPC {
+
+  public:
+
+    enum status_t {
+      OK = 0,                               // result is sent now
+      PENDING,                              // answer later with THiNX::respond()
+      ERROR                                 // result["message"] is sent as error
+    };
+
+    typedef status_t (*method_t)(const char * id, JsonObject & params, JsonObject & result, void * context);
+
+    //! Answer to a call made by the device; error is NULL on success
+    typedef void (*reply_t)(const char * id, JsonVariant result, const char * error, void * context);
+
+    THiNXRPC();
+
+    bool method(const char * name, method_t func, void * context = NULL);
+    method_t find(const char * name, void ** context) const;
+
+    //! Takes a pending slot for id; false when the table is full or id already pending
+    bool begin(const char * id, bool inbound, unsigned long timeout, reply_t reply = NULL, void * context = NULL);
+
+    //! Frees the slot of id; false when unknown (answered or expired already)
+    bool end(const char * id, bool inbound, reply_t * reply = NULL, void ** context = NULL);
+
+    //! Frees one expired slot and returns its id (valid until the next call), or NULL
+    const char * expire(unsigned long now, bool * inbound, reply_t * reply, void ** context);
+
+    bool full() const;
+
+    //! New correlation id for a call made by the device (valid until the next call)
+    const char * next_id();
+
+  private:
+
+    typedef struct {
+      const char * name;
+      method_t func;
+      void * context;
+    } method_entry_t;
+
+    typedef struct {
+      char id[THINX_RPC_ID_SIZE];
+      unsigned long started;
+      unsigned long timeout;
+      reply_t reply;
+      void * context;
+      bool inbound;                         // served by the device
+      bool used;
+    } call_t;
+
+    int8_t lookup(const char * id, bool inbound) const;
+
+    method_entry_t _method[THINX_RPC_METHODS];
+    uint8_t _methods;
+    call_t _call[THINX_RPC_PENDING];
+    char _expired[THINX_RPC_ID_SIZE];
+    char _next[THINX_RPC_ID_SIZE];
+    uint32_t _sequence;
+};
+
+#endif
@@ -0,0 +1,268 @@
+#include "THiNXShadow.h"
+
+#include <EEPROM.h>
+
+#define SLOT_HEADER 6                       // version + key hash
+
+THiNXShadow::THiNXShadow() :
+  _fields(0), _offset(0), _size(0), _used(0),
+  _callback(NULL), _callback_context(NULL)
+{}
+
+void THiNXShadow::begin(uint16_t offset, uint16_t size) {
+  _offset = offset;
+  _size = size;
+  _used = 0;
+  _fields = 0;
+}
+
+uint16_t THiNXShadow::key_hash(const char * key) {
+  uint16_t hash = 5381;                     // djb2, enough to notice a layout change
+  while (*key) {
+    hash = (hash << 5) + hash + (uint8_t) *key++;
+  }
+  return hash;
+}
+
+int8_t THiNXShadow::bind(const char * key, uint8_t type, void * value, uint16_t capacity) {
+
+  if ((_fields >= THINX_SHADOW_FIELDS) || (_used + SLOT_HEADER + capacity > _size)) {
+    return -1;
+  }
+
+  field_t & f = _field[_fields];
+  f.key = key;
+  f.value = value;
+  f.type = type;
+  f.capacity = capacity;
+  f.offset = _offset + _used;
+  f.version = 0;
+  f.allocated = NULL;
+  f.pending = false;
+  _used += SLOT_HEADER + capacity;
+
+  restore(f);
+  return _fields++;
+}
+
+int8_t THiNXShadow::field(const char * key, const char ** value, uint16_t capacity) {
+  return bind(key, STRING, value, capacity);
+}
+
+int8_t THiNXShadow::field(const char * key, long * value) {
+  return bind(key, INTEGER, value, sizeof(long));
+}
+
+int8_t THiNXShadow::field(const char * key, bool * value) {
+  return bind(key, BOOLEAN, value, 1);
+}
+
+void THiNXShadow::restore(field_t & f) {
+
+  uint32_t version = 0;
+  uint16_t hash = 0;
+  for (uint8_t i = 0; i < 4; i++) version |= (uint32_t) EEPROM.read(f.offset + i) << (8 * i);
+  for (uint8_t i = 0; i < 2; i++) hash |= (uint16_t) EEPROM.read(f.offset + 4 + i) << (8 * i);
+
+  if ((version == 0) || (version == 0xFFFFFFFF) || (hash != key_hash(f.key))) {
+    return; // never written, erased or another field's slot: keep the variable
+  }
+
+  f.version = version;
+  uint16_t data = f.offset + SLOT_HEADER;
+
+  switch (f.type) {
+    case STRING: {
+      char * str = (char *) malloc(f.capacity);
+      if (str == NULL) return;
+      for (uint16_t i = 0; i < f.capacity; i++) str[i] = EEPROM.read(data + i);
+      str[f.capacity - 1] = 0;
+      assign(f, str);
+    } break;
+    case INTEGER: {
+      long value = 0;
+      for (uint8_t i = 0; i < sizeof(long); i++) value |= (long) EEPROM.read(data + i) << (8 * i);
+      *(long *) f.value = value;
+    } break;
+    case BOOLEAN:
+      *(bool *) f.value = EEPROM.read(data) != 0;
+      break;
+  }
+}
+
+void THiNXShadow::assign(field_t & f, char * value) {
+  const char ** variable = (const char **) f.value;
+  if ((f.allocated != NULL) && (*variable == f.allocated)) {
+    free(f.allocated);                      // still ours, nobody else points to it
+  }
+  *variable = value;
+  f.allocated = value;
+}
+
+bool THiNXShadow::differs(const field_t & f) const {
+
+  uint16_t data = f.offset + SLOT_HEADER;
+
+  switch (f.type) {
+    case STRING: {
+      const char * str = *(const char **) f.value;
+      if (str == NULL) str = "";
+      for (uint16_t i = 0; i < f.capacity - 1; i++) {
+        if (EEPROM.read(data + i) != (uint8_t) str[i]) return true;
+        if (str[i] == 0) return false;
+      }
+      return false; // equal up to capacity, longer values are stored truncated
+    }
+    case INTEGER: {
+      long value = *(long *) f.value;
+      for (uint8_t i = 0; i < sizeof(long); i++) {
+        if (EEPROM.read(data + i) != (uint8_t)(value >> (8 * i))) return true;
+      }
+      return false;
+    }
+    case BOOLEAN:
+      return EEPROM.read(data) != (*(bool *) f.value ? 1 : 0);
+  }
+  return false;
+}
+
+// Rewrites this field's slot only; EEPROM marks itself dirty on changed bytes
+void THiNXShadow::persist(field_t & f) {
+
+  uint16_t hash = key_hash(f.key);
+  for (uint8_t i = 0; i < 4; i++) EEPROM.write(f.offset + i, (f.version >> (8 * i)) & 0xFF);
+  for (uint8_t i = 0; i < 2; i++) EEPROM.write(f.offset + 4 + i, (hash >> (8 * i)) & 0xFF);
+
+  uint16_t data = f.offset + SLOT_HEADER;
+
+  switch (f.type) {
+    case STRING: {
+      const char * str = *(const char **) f.value;
+      if (str == NULL) str = "";
+      bool end = false;
+      for (uint16_t i = 0; i < f.capacity; i++) {
+        uint8_t c = (end || (i == f.capacity - 1)) ? 0 : str[i];
+        if (c == 0) end = true;
+        EEPROM.write(data + i, c);
+      }
+    } break;
+    case INTEGER: {
+      long value = *(long *) f.value;
+      for (uint8_t i = 0; i < sizeof(long); i++) EEPROM.write(data + i, (value >> (8 * i)) & 0xFF);
+    } break;
+    case BOOLEAN:
+      EEPROM.write(data, *(bool *) f.value ? 1 : 0);
+      break;
+  }
+}
+
+bool THiNXShadow::scan() {
+  bool changed = false;
+  for (uint8_t i = 0; i < _fields; i++) {
+    field_t & f = _field[i];
+    if ((f.version == 0) || differs(f)) {
+      f.version++;
+      f.pending = true;
+      persist(f);
+      changed = true;
+    }
+  }
+  if (changed) EEPROM.commit();
+  return changed;
+}
+
+uint8_t THiNXShadow::apply(JsonObject & message) {
+
+  JsonObject & desired = message["desired"];
+  JsonObject & versions = message["version"];
+  if (!desired.success()) return 0;
+
+  uint8_t changed = 0;
+
+  for (uint8_t i = 0; i < _fields; i++) {
+
+    field_t & f = _field[i];
+    if (!desired.containsKey(f.key)) continue;
+
+    // Missing version means "newer than what the device has"
+    uint32_t version = versions.success() && versions.containsKey(f.key)
+      ? versions[f.key].as<unsigned long>() : f.version + 1;
+
+    if (version <= f.version) {
+      f.pending = true; // stale: report ours so the cloud converges
+      continue;
+    }
+
+    switch (f.type) {
+      case STRING: {
+        const char * str = desired[f.key];
+        if (str == NULL) str = "";
+        char * copy = (strlen(str) < f.capacity) ? strdup(str) : NULL;
+        if (copy == NULL) {
+          f.pending = true; // too long for the slot (or no memory): keep and report ours
+          continue;
+        }
+        assign(f, copy);
+      } break;
+      case INTEGER:
+        *(long *) f.value = desired[f.key].as<long>();
+        break;
+      case BOOLEAN:
+        *(bool *) f.value = desired[f.key].as<bool>();
+        break;
+    }
+
+    f.version = version;
+    f.pending = true; // acknowledge by reporting
+    persist(f);
+    changed++;
+
+    if (_callback) _callback(f.key, _callback_context);
+  }
+
+  if (changed) EEPROM.commit();
+  return changed;
+}
+
+bool THiNXShadow::pending() const {
+  for (uint8_t i = 0; i < _fields; i++) {
+    if (_field[i].pending) return true;
+  }
+  return false;
+}
+
+void THiNXShadow::touch() {
+  for (uint8_t i = 0; i < _fields; i++) {
+    _field[i].pending = true;
+  }
+}
+
+void THiNXShadow::report(JsonObject & root) {
+
+  JsonObject & state = root.createNestedObject("reported");
+  JsonObject & versions = root.createNestedObject("version");
+
+  for (uint8_t i = 0; i < _fields; i++) {
+    const field_t & f = _field[i];
+    if (!f.pending) continue;
+    switch (f.type) {
+      case STRING: {
+        const char * str = *(const char **) f.value;
+        state[f.key] = str ? str : "";
+      } break;
+      case INTEGER:
+        state[f.key] = *(long *) f.value;
+        break;
+      case BOOLEAN:
+        state[f.key] = *(bool *) f.value;
+        break;
+    }
+    versions[f.key] = f.version;
+  }
+}
+
+void THiNXShadow::reported() {
+  for (uint8_t i = 0; i < _fields; i++) {
+    _field[i].pending = false;
+  }
+}
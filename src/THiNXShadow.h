@@ -0,0 +1,104 @@
+#ifndef THiNXShadow_h
+#define THiNXShadow_h
+
+#include <Arduino.h>
+
+#include "ArduinoJson/ArduinoJson.h"
+
+// Fields in the shadow document
+#ifndef THINX_SHADOW_FIELDS
+#define THINX_SHADOW_FIELDS 12
+#endif
+
+//! Device shadow: fields bound to variables, versioned and synced as deltas
+/*!
+  Each field is bound to a variable and owns an EEPROM slot
+
+    <version, 32 bit> <key hash, 16 bit> <value>
+
+  so a change rewrites that slot only and EEPROM is committed only when a
+  value really changed. Messages carry just the fields that changed:
+
+    desired   {"desired":{"alias":"kitchen"},"version":{"alias":7}}
+    reported  {"reported":{"alias":"kitchen"},"version":{"alias":7}}
+
+  A desired value is applied when its version is newer than the field's;
+  local changes (detected by scan()) bump the version and are reported.
+*/
+class THiNXShadow {
+
+  public:
+
+    enum field_type {
+      STRING = 0,                           // const char * variable, strdup'ed on change, shorter than capacity
+      INTEGER,
+      BOOLEAN
+    };
+
+    THiNXShadow();
+
+    //! Sets the EEPROM region for slots; call before binding fields
+    void begin(uint16_t offset, uint16_t size);
+
+    //! Binds a field; restores a persisted value when its slot is valid. Returns index or -1.
+    int8_t field(const char * key, const char ** value, uint16_t capacity);
+    int8_t field(const char * key, char ** value, uint16_t capacity) {
+      return field(key, (const char **) value, capacity);
+    }
+    int8_t field(const char * key, long * value);
+    int8_t field(const char * key, bool * value);
+
+    //! Picks up changes of bound variables made outside the shadow; true if any
+    bool scan();
+
+    //! Applies a desired delta, returns the number of fields changed
+    uint8_t apply(JsonObject & message);
+
+    //! Fields waiting to be reported
+    bool pending() const;
+
+    //! Marks all fields for reporting, e.g. after (re)connect
+    void touch();
+
+    //! Fills root with the reported delta (pending fields only)
+    void report(JsonObject & root);
+
+    //! Clears pending flags after the report was published
+    void reported();
+
+    //! Called for each field changed by apply()
+    void setCallback(void (*func)(const char * key, void * context), void * context = NULL) {
+      _callback = func;
+      _callback_context = context;
+    }
+
+  private:
+
+    typedef struct {
+      const char * key;
+      void * value;
+      uint16_t capacity;                    // value bytes in the slot
+      uint16_t offset;                      // slot address
+      uint32_t version;
+      char * allocated;                     // STRING value made by the shadow, freed when replaced
+      uint8_t type;
+      bool pending;
+    } field_t;
+
+    int8_t bind(const char * key, uint8_t type, void * value, uint16_t capacity);
+    bool differs(const field_t & f) const;  // variable vs. slot
+    void persist(field_t & f);
+    void restore(field_t & f);
+    void assign(field_t & f, char * value); // STRING only
+    static uint16_t key_hash(const char * key);
+
+    field_t _field[THINX_SHADOW_FIELDS];
+    uint8_t _fields;
+    uint16_t _offset;
+    uint16_t _size;
+    uint16_t _used;
+    void (*_callback)(const char *, void *);
+    void * _callback_context;
+};
+
+#endif
@@ -0,0 +1,294 @@
+#include "THiNXTelemetry.h"
+
+THiNXTelemetry::THiNXTelemetry() :
+  _channels(0), _lost(0), _spill(NULL)
+{
+  clear();
+}
+
+void THiNXTelemetry::clear() {
+  _head = 0;
+  _size = 0;
+  _samples = 0;
+  _first = 0;
+  _last = 0;
+  _bucket_head = 0;
+  _buckets = 0;
+}
+
+int8_t THiNXTelemetry::channel(const char * name) {
+  for (uint8_t i = 0; i < _channels; i++) {
+    if (strcmp(_names[i], name) == 0) return i;
+  }
+  if (_channels >= THINX_TELEMETRY_CHANNELS) return -1;
+  _names[_channels] = name;
+  return _channels++;
+}
+
+bool THiNXTelemetry::record(uint8_t channel, float value) {
+  int32_t raw;
+  memcpy(&raw, &value, sizeof(raw));
+  return push(channel, FLOAT, raw, millis());
+}
+
+bool THiNXTelemetry::record(uint8_t channel, long value) {
+  return push(channel, INTEGER, value, millis());
+}
+
+bool THiNXTelemetry::record(uint8_t channel, bool value) {
+  return push(channel, BOOLEAN, value ? 1 : 0, millis());
+}
+
+// Adds a raw sample to the open bucket of its channel, opening one if needed
+void THiNXTelemetry::fold(const thinx_sample_t & sample, unsigned long time) {
+
+  float value;
+  if (sample.type == FLOAT) {
+    memcpy(&value, &sample.value.i, sizeof(value));
+    if (isnan(value) || isinf(value)) return;
+  } else {
+    value = sample.value.i;
+  }
+
+  // Open buckets are among the newest, at most one per channel
+  size_t depth = (_buckets < _channels) ? _buckets : _channels;
+  for (size_t i = 1; i <= depth; i++) {
+    thinx_bucket_t & bucket = _bucket[(_bucket_head + _buckets - i) % THINX_TELEMETRY_BUCKETS];
+    if (bucket.channel != sample.channel) continue;
+    if ((time - bucket.start >= THINX_TELEMETRY_BUCKET_MS) || (bucket.count == 0xFFFF)) break;
+    if (value < bucket.min) bucket.min = value;
+    if (value > bucket.max) bucket.max = value;
+    bucket.sum += value;
+    bucket.count++;
+    return;
+  }
+
+  if (_buckets == THINX_TELEMETRY_BUCKETS) {
+    const thinx_bucket_t & oldest = _bucket[_bucket_head];
+    if ((_spill == NULL) || !_spill(oldest)) {
+      _lost += oldest.count;
+    }
+    _bucket_head = (_bucket_head + 1) % THINX_TELEMETRY_BUCKETS;
+    _buckets--;
+  }
+
+  thinx_bucket_t & bucket = _bucket[(_bucket_head + _buckets) % THINX_TELEMETRY_BUCKETS];
+  bucket.start = time;
+  bucket.count = 1;
+  bucket.channel = sample.channel;
+  bucket.reserved = 0;
+  bucket.min = value;
+  bucket.max = value;
+  bucket.sum = value;
+  _buckets++;
+}
+
+void THiNXTelemetry::drop_oldest() {
+  const thinx_sample_t & oldest = _ring[_head];
+  if (oldest.type != GAP) {
+    _samples--;
+    fold(oldest, _first);
+  }
+  _head = (_head + 1) % THINX_TELEMETRY_SAMPLES;
+  _size--;
+  if (_size == 0) return;
+  // The new oldest record absorbs its delta into the base time
+  thinx_sample_t & next = _ring[_head];
+  _first += next.delta;
+  if (next.type == GAP) _first += next.value.i;
+  next.delta = 0;
+  if (next.type == GAP) next.value.i = 0;
+}
+
+bool THiNXTelemetry::push(uint8_t channel, uint8_t type, int32_t raw, unsigned long now) {
+
+  if (channel >= _channels) return false;
+
+  unsigned long delta = (_size == 0) ? 0 : (now - _last);
+
+  // Deltas above 16 bits are carried by a GAP marker
+  if (delta > 0xFFFF) {
+    if (_size == THINX_TELEMETRY_SAMPLES) drop_oldest();
+    thinx_sample_t & gap = _ring[(_head + _size) % THINX_TELEMETRY_SAMPLES];
+    gap.delta = 0;
+    gap.channel = 0;
+    gap.type = GAP;
+    gap.value.i = delta;
+    _size++;
+    delta = 0;
+  }
+
+  if (_size == THINX_TELEMETRY_SAMPLES) drop_oldest();
+  if (_size == 0) _first = now;
+
+  thinx_sample_t & sample = _ring[(_head + _size) % THINX_TELEMETRY_SAMPLES];
+  sample.delta = delta;
+  sample.channel = channel;
+  sample.type = type;
+  sample.value.i = raw;
+  _size++;
+  _samples++;
+  _last = now;
+  return true;
+}
+
+bool THiNXTelemetry::due(unsigned long now) const {
+  if (_buckets > 0) return true;            // backlog from an offline period, drain now
+  if (_samples == 0) return false;
+  return (_samples >= THINX_TELEMETRY_BATCH) || (now - _first >= THINX_TELEMETRY_INTERVAL);
+}
+
+size_t THiNXTelemetry::printValue(Print & out, float value) {
+  if (isnan(value) || isinf(value)) {
+    return out.print("null");
+  }
+  return out.print(value, 3);
+}
+
+size_t THiNXTelemetry::printBuckets(Print & out, const thinx_bucket_t * buckets, size_t count) {
+  size_t n = 0;
+  for (size_t i = 0; i < count; i++) {
+    const thinx_bucket_t & bucket = buckets[i];
+    if (i) n += out.print(',');
+    n += out.print((unsigned long) bucket.start); n += out.print(',');
+    n += out.print((int) bucket.channel); n += out.print(',');
+    n += out.print((unsigned int) bucket.count); n += out.print(',');
+    n += printValue(out, bucket.min); n += out.print(',');
+    n += printValue(out, bucket.max); n += out.print(',');
+    n += printValue(out, bucket.sum / bucket.count);
+  }
+  return n;
+}
+
+size_t THiNXTelemetry::printTo(Print & out, unsigned long now) const {
+
+  size_t n = 0;
+  n += out.print("{\"t\":"); n += out.print(_first);
+  n += out.print(",\"up\":"); n += out.print(now);
+  n += out.print(",\"n\":[");
+  for (uint8_t i = 0; i < _channels; i++) {
+    if (i) n += out.print(',');
+    n += out.print('"'); n += out.print(_names[i]); n += out.print('"');
+  }
+  n += out.print("],\"d\":[");
+
+  unsigned long carry = 0;
+  bool first = true;
+  for (size_t i = 0; i < _size; i++) {
+    const thinx_sample_t & sample = at(i);
+    if (sample.type == GAP) {
+      carry += sample.value.i;
+      continue;
+    }
+    if (!first) n += out.print(',');
+    first = false;
+    n += out.print(carry + sample.delta); n += out.print(',');
+    n += out.print((int) sample.channel); n += out.print(',');
+    carry = 0;
+    switch (sample.type) {
+      case FLOAT: {
+        float value;
+        memcpy(&value, &sample.value.i, sizeof(value));
+        n += printValue(out, value);
+        break;
+      }
+      case INTEGER:
+        n += out.print((long) sample.value.i);
+        break;
+      case BOOLEAN:
+        n += out.print(sample.value.i ? "true" : "false");
+        break;
+    }
+  }
+
+  n += out.print("],\"b\":[");
+  // Oldest first; the ring may wrap, so print it as two contiguous runs
+  size_t run = THINX_TELEMETRY_BUCKETS - _bucket_head;
+  if (run > _buckets) run = _buckets;
+  n += printBuckets(out, _bucket + _bucket_head, run);
+  if (run < _buckets) {
+    if (run) n += out.print(',');
+    n += printBuckets(out, _bucket, _buckets - run);
+  }
+
+  n += out.print("],\"lost\":"); n += out.print(_lost);
+  n += out.print('}');
+  return n;
+}
+
+void THiNXTelemetry::packValue(THiNXMsgPack & out, float value) {
+  if (isnan(value) || isinf(value)) {
+    out.nil();
+  } else {
+    out.number(value);
+  }
+}
+
+void THiNXTelemetry::packBuckets(THiNXMsgPack & out, const thinx_bucket_t * buckets, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    const thinx_bucket_t & bucket = buckets[i];
+    out.uinteger(bucket.start);
+    out.uinteger(bucket.channel);
+    out.uinteger(bucket.count);
+    packValue(out, bucket.min);
+    packValue(out, bucket.max);
+    packValue(out, bucket.sum / bucket.count);
+  }
+}
+
+// Map header, keys, three 32-bit numbers and array headers; per sample a
+// 32-bit delta, the channel and a value; per bucket three 32-bit integers
+// and three floats
+size_t THiNXTelemetry::packedSize() const {
+  size_t size = 48 + _samples * 11 + _buckets * 24;
+  for (uint8_t i = 0; i < _channels; i++) {
+    size += strlen(_names[i]) + 3;
+  }
+  return size;
+}
+
+void THiNXTelemetry::packTo(THiNXMsgPack & out, unsigned long now) const {
+
+  out.map(6);
+  out.str("t"); out.uinteger(_first);
+  out.str("up"); out.uinteger(now);
+  out.str("n"); out.array(_channels);
+  for (uint8_t i = 0; i < _channels; i++) {
+    out.str(_names[i]);
+  }
+
+  out.str("d"); out.array(_samples * 3);
+  unsigned long carry = 0;
+  for (size_t i = 0; i < _size; i++) {
+    const thinx_sample_t & sample = at(i);
+    if (sample.type == GAP) {
+      carry += sample.value.i;
+      continue;
+    }
+    out.uinteger(carry + sample.delta);
+    out.uinteger(sample.channel);
+    carry = 0;
+    switch (sample.type) {
+      case FLOAT: {
+        float value;
+        memcpy(&value, &sample.value.i, sizeof(value));
+        packValue(out, value);
+        break;
+      }
+      case INTEGER:
+        out.integer(sample.value.i);
+        break;
+      case BOOLEAN:
+        out.boolean(sample.value.i != 0);
+        break;
+    }
+  }
+
+  out.str("b"); out.array(_buckets * 6);
+  size_t run = THINX_TELEMETRY_BUCKETS - _bucket_head;
+  if (run > _buckets) run = _buckets;
+  packBuckets(out, _bucket + _bucket_head, run);
+  packBuckets(out, _bucket, _buckets - run);
+
+  out.str("lost"); out.uinteger(_lost);
+}
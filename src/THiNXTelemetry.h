@@ -0,0 +1,155 @@
+#ifndef THiNXTelemetry_h
+#define THiNXTelemetry_h
+
+#include <Arduino.h>
+
+#include "THiNXMsgPack.h"
+
+// Samples held between flushes (8 bytes each)
+#ifndef THINX_TELEMETRY_SAMPLES
+#define THINX_TELEMETRY_SAMPLES 64
+#endif
+
+// Named channels per device
+#ifndef THINX_TELEMETRY_CHANNELS
+#define THINX_TELEMETRY_CHANNELS 8
+#endif
+
+// Flush a batch after this many ms since its first sample...
+#ifndef THINX_TELEMETRY_INTERVAL
+#define THINX_TELEMETRY_INTERVAL 10000UL
+#endif
+
+// ...or once this many samples are queued
+#ifndef THINX_TELEMETRY_BATCH
+#define THINX_TELEMETRY_BATCH 48
+#endif
+
+// Downsampled buckets kept in RAM once raw samples are pushed out (20 bytes each)
+#ifndef THINX_TELEMETRY_BUCKETS
+#define THINX_TELEMETRY_BUCKETS 32
+#endif
+
+// Time span of one bucket (ms)
+#ifndef THINX_TELEMETRY_BUCKET_MS
+#define THINX_TELEMETRY_BUCKET_MS 60000UL
+#endif
+
+typedef struct {
+  uint16_t delta;                           // ms since previous sample
+  uint8_t channel;
+  uint8_t type;                             // THiNXTelemetry::sample_type
+  union {
+    float f;
+    int32_t i;
+  } value;
+} thinx_sample_t;
+
+typedef struct {
+  uint32_t start;                           // ms of the first sample
+  uint16_t count;
+  uint8_t channel;
+  uint8_t reserved;
+  float min;
+  float max;
+  float sum;
+} thinx_bucket_t;
+
+//! Fixed-size ring of typed samples, flushed as one batched message
+/*!
+  Timestamps are stored as deltas to the previous sample. When the raw ring
+  is full (typically while offline) the oldest samples are folded into
+  per-channel min/max/mean buckets of THINX_TELEMETRY_BUCKET_MS; when the
+  bucket ring is full too, the oldest bucket goes to the spill handler
+  (flash tier) or is dropped and counted as lost. A batch is printed as
+
+    {"t":<ms of first sample>,"up":<ms now>,"n":["temp",...],"d":[dt,ch,v,...],
+     "b":[start,ch,count,min,max,mean,...],"lost":n}
+
+  where dt is the delta to the previous sample and ch indexes "n"; the server
+  anchors "t" and bucket starts by subtracting "up" from its receive time.
+  packTo() writes the same map as MessagePack.
+*/
+class THiNXTelemetry {
+
+  public:
+
+    enum sample_type {
+      FLOAT = 0,
+      INTEGER,
+      BOOLEAN,
+      GAP                                   // no sample, value.i extends the next delta
+    };
+
+    THiNXTelemetry();
+
+    //! Registers a channel name (caller keeps the string), returns its id or -1 when full
+    int8_t channel(const char * name);
+
+    bool record(uint8_t channel, float value);
+    bool record(uint8_t channel, long value);
+    bool record(uint8_t channel, bool value);
+
+    // Literals, analogRead() and millis() would match several of the above
+    bool record(uint8_t channel, double value) { return record(channel, (float) value); }
+    bool record(uint8_t channel, int value) { return record(channel, (long) value); }
+    bool record(uint8_t channel, unsigned int value) { return record(channel, (long) value); }
+    bool record(uint8_t channel, unsigned long value) { return record(channel, (long) value); }
+
+    //! Samples and buckets waiting (GAP markers excluded)
+    size_t count() const { return _samples + _buckets; }
+
+    //! Receives the oldest bucket when the bucket ring is full, false if it was not kept
+    void setSpill(bool (*func)(const thinx_bucket_t &)) { _spill = func; }
+
+    //! Samples overwritten before they could be sent
+    uint32_t lost() const { return _lost; }
+
+    //! True when the queued batch should be sent
+    bool due(unsigned long now) const;
+
+    //! Writes the queued batch as JSON
+    size_t printTo(Print & out, unsigned long now) const;
+
+    //! Writes the queued batch as MessagePack
+    void packTo(THiNXMsgPack & out, unsigned long now) const;
+
+    //! Upper bound of the packTo() size
+    size_t packedSize() const;
+
+    //! Drops everything after a successful send
+    void clear();
+
+    //! Writes bucket tuples (without brackets), e.g. read back from the flash tier
+    static size_t printBuckets(Print & out, const thinx_bucket_t * buckets, size_t count);
+
+    //! Writes bucket tuples (without array header) as MessagePack
+    static void packBuckets(THiNXMsgPack & out, const thinx_bucket_t * buckets, size_t count);
+
+  private:
+    bool push(uint8_t channel, uint8_t type, int32_t raw, unsigned long now);
+    void drop_oldest();
+    void fold(const thinx_sample_t & sample, unsigned long time);
+    static size_t printValue(Print & out, float value);
+    static void packValue(THiNXMsgPack & out, float value);
+    const thinx_sample_t & at(size_t index) const {
+      return _ring[(_head + index) % THINX_TELEMETRY_SAMPLES];
+    }
+
+    thinx_sample_t _ring[THINX_TELEMETRY_SAMPLES];
+    const char * _names[THINX_TELEMETRY_CHANNELS];
+    uint8_t _channels;
+    size_t _head;                           // oldest record
+    size_t _size;                           // records incl. GAP markers
+    size_t _samples;
+    unsigned long _first;                   // ms of the oldest record
+    unsigned long _last;                    // ms of the newest record
+    uint32_t _lost;
+
+    thinx_bucket_t _bucket[THINX_TELEMETRY_BUCKETS];
+    size_t _bucket_head;
+    size_t _buckets;
+    bool (*_spill)(const thinx_bucket_t &);
+};
+
+#endif
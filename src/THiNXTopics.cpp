@@ -0,0 +1,68 @@
+#include "THiNXTopics.h"
+
+// Suffixes in order of THiNXTopics::topic_id
+static const char * const thinx_topic_suffix[THiNXTopics::COUNT] = {
+  "",
+  "/status",
+  "/telemetry",
+  "/command",
+  "/update",
+  "/notification",
+  "/status/msgpack",
+  "/telemetry/msgpack",
+  "/command/#",
+  "/rpc",
+  "/rpc/out",
+  "/shadow/desired",
+  "/shadow/reported"
+};
+
+THiNXTopics::THiNXTopics() {
+  clear();
+}
+
+void THiNXTopics::clear() {
+  _prefix[0] = 0;
+  _prefix_length = 0;
+  _ready = false;
+}
+
+bool THiNXTopics::build(const char * owner, const char * udid) {
+
+  size_t owner_len = strlen(owner);
+  size_t udid_len = strlen(udid);
+  size_t prefix_len = 1 + owner_len + 1 + udid_len; // "/owner/udid"
+
+  if (prefix_len + 1 > THINX_TOPIC_PREFIX_SIZE) {
+    clear();
+    return false;
+  }
+
+  _prefix[0] = '/';
+  memcpy(_prefix + 1, owner, owner_len);
+  _prefix[1 + owner_len] = '/';
+  memcpy(_prefix + 2 + owner_len, udid, udid_len);
+  _prefix[prefix_len] = 0;
+
+  _prefix_length = prefix_len;
+  _ready = true;
+  return true;
+}
+
+THiNXTopics::name_t THiNXTopics::name(topic_id id) const {
+  name_t topic;
+  memcpy(topic.str, _prefix, _prefix_length);
+  strcpy(topic.str + _prefix_length, _ready ? thinx_topic_suffix[id] : "");
+  return topic;
+}
+
+uint16_t THiNXTopics::length(topic_id id) const {
+  if (!_ready) return 0;
+  return _prefix_length + strlen(thinx_topic_suffix[id]);
+}
+
+MQTT::TopicRef THiNXTopics::ref(topic_id id) const {
+  const char * suffix = _ready ? thinx_topic_suffix[id] : "";
+  MQTT::TopicRef topic = { _prefix, _prefix_length, suffix, (uint16_t) strlen(suffix) };
+  return topic;
+}
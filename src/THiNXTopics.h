@@ -0,0 +1,75 @@
+#ifndef THiNXTopics_h
+#define THiNXTopics_h
+
+#include <Arduino.h>
+
+#include "PubSubClient/MQTT.h"
+
+// Longest "/owner/udid" incl. terminator, see THINX_OWNER_SIZE and THINX_UDID_SIZE
+#ifndef THINX_TOPIC_PREFIX_SIZE
+#define THINX_TOPIC_PREFIX_SIZE 133
+#endif
+
+// Longest suffix, "/telemetry/msgpack"
+#define THINX_TOPIC_SUFFIX_SIZE 18
+
+//! Device MQTT topics: "/owner/udid" stored once, suffixes kept as constants
+/*!
+  The prefix is only rebuilt on registration or udid change. ref() points at
+  the prefix and the suffix without joining them, so any number of views stay
+  valid until the next build(). name() returns a joined copy for callers that
+  need one C string.
+*/
+class THiNXTopics {
+
+  public:
+
+    enum topic_id {
+      DEVICE = 0,                           // /owner/udid
+      STATUS,                               // /owner/udid/status
+      TELEMETRY,                            // /owner/udid/telemetry
+      COMMAND,                              // /owner/udid/command
+      UPDATE,                               // /owner/udid/update
+      NOTIFICATION,                         // /owner/udid/notification
+      STATUS_MSGPACK,                       // /owner/udid/status/msgpack
+      TELEMETRY_MSGPACK,                    // /owner/udid/telemetry/msgpack
+      COMMAND_ALL,                          // /owner/udid/command/# (subscription filter)
+      RPC,                                  // /owner/udid/rpc, requests and replies to the device
+      RPC_OUT,                              // /owner/udid/rpc/out, requests and replies from the device
+      SHADOW_DESIRED,                       // /owner/udid/shadow/desired
+      SHADOW_REPORTED,                      // /owner/udid/shadow/reported
+      COUNT
+    };
+
+    //! Joined topic name, owned by the caller
+    struct name_t {
+      char str[THINX_TOPIC_PREFIX_SIZE + THINX_TOPIC_SUFFIX_SIZE];
+      const char * c_str() const { return str; }
+    };
+
+    THiNXTopics();
+
+    //! Formats all topics, returns false (and leaves the table empty) on overflow
+    bool build(const char * owner, const char * udid);
+
+    //! True after a successful build()
+    bool ready() const { return _ready; }
+
+    //! NUL-terminated topic name, empty string before build()
+    name_t name(topic_id id) const;
+
+    //! Topic name length without terminator
+    uint16_t length(topic_id id) const;
+
+    //! View for PubSubClient::publish() that avoids a String copy, valid until build()
+    MQTT::TopicRef ref(topic_id id) const;
+
+  private:
+    void clear();
+
+    char _prefix[THINX_TOPIC_PREFIX_SIZE];
+    uint8_t _prefix_length;
+    bool _ready;
+};
+
+#endif
@@ -20,5 +20,12 @@ const long THINX_API_PORT = 7442;
 const bool THINX_AUTO_UPDATE = true;
 const bool THINX_FORCED_UPDATE = false;
 
+#ifndef THINX_CHECKIN_SPREAD
+#define THINX_CHECKIN_SPREAD 60       // seconds, first check-in is delayed by up to this (per chip id)
+#endif
+#ifndef THINX_CHECKIN_INTERVAL
+#define THINX_CHECKIN_INTERVAL 3600   // seconds between periodic check-ins, 0 = only once
+#endif
+
 const char * THINX_ENV_SSID = "THiNX-IoT+";     //  your network SSID (name)
 const char * THINX_ENV_PASS = "<enter-your-ssid-password>";  // your network password
@@ -0,0 +1,95 @@
+// Check-in load after a site-wide power outage: the whole fleet boots at the
+// same moment and the API sees when each device registers. Built twice, with
+// the THINX_CHECKIN_SPREAD of thinx.h and with 0 (everyone at WiFi-up).
+
+#include <THiNXLib.h>
+
+#include "mock/sim.h"
+#include "test.h"
+
+#ifndef THINX_CHECKIN_SPREAD
+#define THINX_CHECKIN_SPREAD 60             // as in thinx.h, which only the library includes
+#endif
+
+#define DEVICES 500
+#define RUN_MS 90000UL
+
+static const char * apikey = "4721f08a6df1a36b8517f678768effa8b3f2e53a7a1934423c1f42758dd83db5";
+
+// Powers the device on and runs the sketch loop for run_ms
+static void boot(SimDevice & device, unsigned long run_ms) {
+  sim_select(device);
+  sim_wake(false);
+  THiNX * thx = new THiNX(); // never deleted, keeps the run simple
+  thx->init(apikey);
+  while (millis() < run_ms) {
+    thx->loop();
+    delay(10);
+  }
+}
+
+// Check-ins of one device, in order
+static std::vector<uint64_t> requests_of(uint32_t chip_id) {
+  std::vector<uint64_t> at;
+  for (size_t i = 0; i < sim_requests.size(); i++) {
+    if (sim_requests[i].chip_id == chip_id) at.push_back(sim_requests[i].at_us);
+  }
+  return at;
+}
+
+int main() {
+
+  static SimDevice fleet[DEVICES];
+  uint32_t chip_id = 0x1234;
+  for (int i = 0; i < DEVICES; i++) {
+    chip_id = (chip_id * 1103515245 + 12345) & 0xFFFFFF; // chip ids are the low MAC bytes
+    sim_init(fleet[i], chip_id);
+    boot(fleet[i], RUN_MS);
+  }
+
+  unsigned per_second[RUN_MS / 1000] = { 0 };
+  unsigned peak = 0;
+  uint64_t last_us = 0;
+  for (size_t i = 0; i < sim_requests.size(); i++) {
+    unsigned & n = per_second[sim_requests[i].at_us / 1000000];
+    if (++n > peak) peak = n;
+    if (sim_requests[i].at_us > last_us) last_us = sim_requests[i].at_us;
+  }
+
+  printf("  %d devices, THINX_CHECKIN_SPREAD %d s: %zu check-ins, peak %u per second, last at %.1f s\n",
+         DEVICES, THINX_CHECKIN_SPREAD, sim_requests.size(), peak, last_us / 1e6);
+  printf("  per 10 s:");
+  for (unsigned s = 0; s < RUN_MS / 1000; s += 10) {
+    unsigned n = 0;
+    for (unsigned k = s; k < s + 10; k++) n += per_second[k];
+    printf(" %u", n);
+  }
+  printf("\n");
+
+  CHECK(sim_requests.size() == DEVICES); // once each, the next is an interval away
+  CHECK(last_us < (THINX_CHECKIN_SPREAD + 5) * 1000000ULL);
+  if (THINX_CHECKIN_SPREAD >= 30) {
+    // offsets shorter than the WiFi scan all fire at WiFi-up, the peak second
+    CHECK(peak <= DEVICES / 10);
+  } else {
+    CHECK(peak > DEVICES / 2);              // the spike the spread avoids
+  }
+
+  // The offset depends on the chip id only
+  SimDevice again;
+  sim_init(again, fleet[0].chip_id);
+  boot(again, 5000 + THINX_CHECKIN_SPREAD * 1000UL);
+  std::vector<uint64_t> at = requests_of(fleet[0].chip_id);
+  CHECK(at.size() == 2 && (at[1] / 1000 == at[0] / 1000));
+
+  // A slot hint from the server moves the next check-in
+  sim_link.checkin_slot = 120;
+  SimDevice hinted;
+  sim_init(hinted, 0xABCDEF);
+  boot(hinted, 200000);
+  at = requests_of(0xABCDEF);
+  CHECK(at.size() == 2 && (at[1] - at[0] >= 120000000ULL) && (at[1] - at[0] < 122000000ULL));
+  sim_link.checkin_slot = 0;
+
+  return test_result(THINX_CHECKIN_SPREAD ? "fleet" : "fleet (no spread)");
+}
@@ -0,0 +1,61 @@
+#pragma once
+// Host stand-ins for the ESP8266 Arduino core, implemented by sim.cpp
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <functional>
+#include "pgmspace.h"
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "Client.h"
+#include "IPAddress.h"
+
+#ifndef ESP8266
+#define ESP8266
+#endif
+typedef uint8_t byte;
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long);
+void yield();
+long random(long);
+long random(long, long);
+void randomSeed(unsigned long);
+class HardwareSerial : public Stream {
+ public:
+  size_t write(uint8_t);
+  int available() { return 0; }
+  int read() { return -1; }
+  int peek() { return -1; }
+  void begin(unsigned long) {}
+  void setDebugOutput(bool) {}
+  operator bool() { return true; }
+};
+extern HardwareSerial Serial;
+class EspClass {
+ public:
+  uint32_t getChipId();
+  uint32_t getFlashChipRealSize();
+  uint32_t getFlashChipSize();
+  uint32_t getFreeSketchSpace();
+  uint32_t getFreeHeap();
+  void restart();
+  void deepSleep(uint64_t us, int mode = 0);
+  bool rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size);
+  bool rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size);
+  bool updateSketch(Stream&, uint32_t, bool, bool);
+  uint32_t getCycleCount();
+  struct rst_info* getResetInfoPtr();
+};
+extern EspClass ESP;
+void wdt_disable();
+void wdt_enable(unsigned long);
+#define ETS_UART_INTR_DISABLE()
+#define ETS_UART_INTR_ENABLE()
+#define RF_DEFAULT 0
+#define RF_NO_CAL 2
+#define WAKE_RF_DEFAULT 0
+#define WAKE_NO_RFCAL 2
+struct rst_info;
@@ -0,0 +1,10 @@
+#pragma once
+#include "Arduino.h"
+class EEPROMClass {
+ public:
+  void begin(size_t); uint8_t read(int); void write(int, uint8_t); bool commit();
+  template <typename T> T& get(int a, T& t) { memcpy(&t, getDataPtr() + a, sizeof(T)); return t; }
+  template <typename T> const T& put(int a, const T& t) { memcpy(getDataPtr() + a, &t, sizeof(T)); return t; }
+  uint8_t* getDataPtr();
+};
+extern EEPROMClass EEPROM;
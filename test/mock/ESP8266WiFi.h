@@ -0,0 +1,56 @@
+#pragma once
+#include "Arduino.h"
+typedef enum { WL_IDLE_STATUS = 0, WL_NO_SSID_AVAIL, WL_SCAN_COMPLETED, WL_CONNECTED, WL_CONNECT_FAILED, WL_CONNECTION_LOST, WL_DISCONNECTED } wl_status_t;
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } WiFiMode_t;
+class ESP8266WiFiClass {
+ public:
+  wl_status_t status();
+  WiFiMode_t getMode();
+  bool mode(WiFiMode_t);
+  String SSID();
+  String psk();
+  uint8_t* BSSID();
+  String BSSIDstr();
+  int32_t channel();
+  int32_t RSSI();
+  IPAddress localIP();
+  IPAddress gatewayIP();
+  IPAddress subnetMask();
+  IPAddress dnsIP(uint8_t = 0);
+  wl_status_t begin();
+  wl_status_t begin(const char* ssid, const char* pass = NULL, int32_t channel = 0, const uint8_t* bssid = NULL, bool connect = true);
+  bool config(IPAddress, IPAddress, IPAddress, IPAddress = IPAddress(), IPAddress = IPAddress());
+  bool softAP(const char*, const char*);
+  bool disconnect(bool = false);
+  bool persistent(bool);
+  bool getPersistent();
+  bool setAutoConnect(bool);
+  bool forceSleepBegin();
+  bool forceSleepWake();
+  String macAddress();
+  int hostByName(const char*, IPAddress&);
+};
+extern ESP8266WiFiClass WiFi;
+struct SimSocket;
+class WiFiClient : public Client {
+ public:
+  WiFiClient() : _socket(0) {}
+  ~WiFiClient() { stop(); }
+  int connect(IPAddress ip, uint16_t port);
+  int connect(const char* host, uint16_t port);
+  using Print::write;
+  size_t write(uint8_t);
+  size_t write(const uint8_t* buf, size_t size);
+  int available();
+  int read();
+  int read(uint8_t* buf, size_t size);
+  int peek();
+  void flush();
+  void stop();
+  uint8_t connected();
+  operator bool();
+  void setNoDelay(bool);
+  void setTimeout(unsigned long);
+ private:
+  SimSocket* _socket;                       // connection to a simulated server, see sim.h
+};
@@ -0,0 +1,5 @@
+#pragma once
+#include "ESP8266WiFi.h"
+enum t_httpUpdate_return { HTTP_UPDATE_FAILED, HTTP_UPDATE_NO_UPDATES, HTTP_UPDATE_OK };
+class ESP8266HTTPUpdate { public: t_httpUpdate_return update(const String& host, uint16_t port, const String& uri = "/", const String& version = ""); };
+extern ESP8266HTTPUpdate ESPhttpUpdate;
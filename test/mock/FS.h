@@ -0,0 +1,9 @@
+#pragma once
+#include "Arduino.h"
+class File : public Stream {
+ public:
+  size_t write(uint8_t); using Print::write; size_t write(const uint8_t*, size_t);
+  int available(); int read(); int peek(); size_t read(uint8_t*, size_t); size_t size(); void close(); operator bool() const; bool seek(uint32_t);
+};
+class FS { public: bool begin(); bool format(); bool exists(const char*); File open(const char*, const char*); bool remove(const char*); };
+extern FS SPIFFS;
@@ -0,0 +1,11 @@
+#pragma once
+#include <stdint.h>
+class IPAddress {
+ public:
+  uint32_t v;
+  IPAddress() : v(0) {}
+  IPAddress(uint32_t x) : v(x) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : v(a | b << 8 | c << 16 | (uint32_t)d << 24) {}
+  operator uint32_t() const { return v; }
+  bool isSet() const { return v != 0; }
+};
@@ -0,0 +1,11 @@
+#pragma once
+#include "Print.h"
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  size_t readBytes(char* b, size_t n) { size_t i = 0; while (i < n) { int c = read(); if (c < 0) break; b[i++] = c; } return i; }
+  String readStringUntil(char) { return String(); }
+  void setTimeout(unsigned long) {}
+};
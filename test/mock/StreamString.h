@@ -0,0 +1,11 @@
+#pragma once
+#include "Stream.h"
+class StreamString : public Stream, public String {
+ public:
+  int available() { return 0; }
+  int read() { return -1; }
+  int peek() { return -1; }
+ public:
+  size_t write(uint8_t c) { concat((char)c); return 1; }
+  using Print::write;
+};
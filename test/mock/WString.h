@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+class StringSumHelper;
+class String {
+ public:
+  std::string s;
+  String() {}
+  String(const char* c) : s(c ? c : "") {}
+  String(const std::string& c) : s(c) {}
+  String(const __FlashStringHelper* c) : s((const char*)c) {}
+  explicit String(char c) : s(1, c) {}
+  explicit String(int v) : s(std::to_string(v)) {}
+  explicit String(unsigned v) : s(std::to_string(v)) {}
+  explicit String(long v) : s(std::to_string(v)) {}
+  explicit String(unsigned long v) : s(std::to_string(v)) {}
+  explicit String(float v) : s(std::to_string(v)) {}
+  explicit String(double v) : s(std::to_string(v)) {}
+  const char* c_str() const { return s.c_str(); }
+  unsigned length() const { return s.size(); }
+  bool reserve(unsigned n) { s.reserve(n); return true; }
+  int indexOf(const char* x) const { size_t p = s.find(x); return p == std::string::npos ? -1 : (int)p; }
+  int indexOf(char x) const { size_t p = s.find(x); return p == std::string::npos ? -1 : (int)p; }
+  int indexOf(const String& x) const { return indexOf(x.c_str()); }
+  String substring(unsigned a, unsigned b) const { return String(s.substr(a, b - a)); }
+  String substring(unsigned a) const { return String(s.substr(a)); }
+  bool equals(const String& o) const { return s == o.s; }
+  bool equals(const char* o) const { return s == o; }
+  bool startsWith(const String& o) const { return s.compare(0, o.s.size(), o.s) == 0; }
+  void replace(const String& a, const String& b) { size_t p; while ((p = s.find(a.s)) != std::string::npos) s.replace(p, a.s.size(), b.s); }
+  char charAt(unsigned i) const { return i < s.size() ? s[i] : 0; }
+  char operator[](unsigned i) const { return charAt(i); }
+  char& operator[](unsigned i);
+  bool concat(char c) { s += c; return true; }
+  bool endsWith(const char* x) const { size_t n = strlen(x); return s.size() >= n && s.compare(s.size() - n, n, x) == 0; }
+  bool concat(const char* c) { s += c; return true; }
+  bool concat(const String& c) { s += c.s; return true; }
+  String& operator+=(const String& o) { s += o.s; return *this; }
+  String& operator+=(const char* o) { s += o; return *this; }
+  String& operator+=(char o) { s += o; return *this; }
+  bool operator==(const String& o) const { return s == o.s; }
+  bool operator==(const char* o) const { return s == o; }
+  bool operator!=(const String& o) const { return s != o.s; }
+  bool operator!=(const char* o) const { return s != o; }
+  typedef void (String::*StringIfHelperType)() const;
+  void StringIfHelper() const {}
+  operator StringIfHelperType() const { return &String::StringIfHelper; }
+  long toInt() const { return atol(s.c_str()); }
+  void toCharArray(char* b, unsigned n) const { strncpy(b, s.c_str(), n); if (n) b[n-1] = 0; }
+  void trim() {}
+};
+class StringSumHelper : public String {
+ public:
+  StringSumHelper(const String& s) : String(s) {}
+  StringSumHelper(const char* s) : String(s) {}
+};
+inline StringSumHelper operator+(const String& a, const String& b) { return StringSumHelper(String(a.s + b.s)); }
+inline StringSumHelper operator+(const String& a, const char* b) { return StringSumHelper(String(a.s + b)); }
+inline StringSumHelper operator+(const char* a, const String& b) { return StringSumHelper(String(a + b.s)); }
+inline StringSumHelper operator+(const String& a, char b) { return StringSumHelper(String(a.s + b)); }
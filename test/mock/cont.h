@@ -0,0 +1,3 @@
+#pragma once
+typedef struct { unsigned int stack[1024]; } cont_t;
+int cont_get_free_stack(cont_t*);
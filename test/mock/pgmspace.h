@@ -0,0 +1,11 @@
+#pragma once
+#include <string.h>
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define strlen_P strlen
+#define strncpy_P strncpy
+#define memcpy_P memcpy
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_byte_near(p) (*(const uint8_t*)(p))
+#define strcmp_P strcmp
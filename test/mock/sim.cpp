@@ -0,0 +1,522 @@
+// Mock Arduino core on top of the simulated devices and servers of sim.h
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <FS.h>
+#include <ESP8266WiFi.h>
+#include <ESP8266httpUpdate.h>
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+
+#include "sim.h"
+
+extern "C" {
+  #include "user_interface.h"
+  #include "cont.h"
+}
+
+SimLink sim_link = {
+  2500,                                     // scan_ms
+  250,                                      // fast_connect_ms
+  40,                                       // tcp_connect_ms
+  150,                                      // api_ms
+  30,                                       // broker_ms
+  10,                                       // byte_us
+  0,                                        // checkin_slot
+  false,                                    // api_down
+  0                                         // api_accept_bytes
+};
+
+std::vector<SimRequest> sim_requests;
+bool sim_verbose = false;
+
+static SimDevice * sim = NULL;
+static std::set<uint32_t> sim_sessions;    // chip ids with a persistent broker session
+
+struct SimMessage {
+  std::string topic;
+  std::string payload;
+  uint16_t packet_id;
+  bool delivered;                           // sent before, redelivered with DUP
+};
+
+static std::map<uint32_t, std::deque<SimMessage> > sim_queued; // unacknowledged, by chip id
+
+void sim_init(SimDevice & device, uint32_t chip_id) {
+  memset(&device, 0, sizeof(device));
+  device.chip_id = chip_id;
+  device.random_state = chip_id | 1;
+  device.wifi_persistent = true;
+}
+
+void sim_select(SimDevice & device) {
+  sim = &device;
+}
+
+void sim_wake(bool from_deep_sleep) {
+  sim->now_us = 0;
+  sim->reset_reason = from_deep_sleep ? REASON_DEEP_SLEEP_AWAKE : 0;
+  sim->wifi_connected = false;
+  sim->wifi_connecting = false;
+  sim->wifi_fast = false;
+  sim->static_ip = 0;
+  sim->sleeping = false;
+  sim->sleep_us = 0;
+  sim->radio_us = 0;
+  sim->tx_bytes = 0;
+  sim->rx_bytes = 0;
+  sim->api_requests = 0;
+  sim->mqtt_connects = 0;
+  sim->mqtt_publishes = 0;
+  sim->restarts = 0;
+}
+
+void sim_queue(uint32_t chip_id, const char * topic, const char * payload) {
+  static uint16_t packet_id = 0;
+  SimMessage message = { topic, payload, ++packet_id, false };
+  sim_queued[chip_id].push_back(message);
+}
+
+/*
+ * Core
+ */
+
+HardwareSerial Serial;
+EspClass ESP;
+EEPROMClass EEPROM;
+FS SPIFFS;
+ESP8266WiFiClass WiFi;
+ESP8266HTTPUpdate ESPhttpUpdate;
+cont_t g_cont;
+
+unsigned long millis() { return sim->now_us / 1000; }
+unsigned long micros() { return sim->now_us; }
+void delay(unsigned long ms) { sim->now_us += ms * 1000ULL; }
+void yield() {}
+
+void randomSeed(unsigned long seed) { sim->random_state = seed | 1; }
+
+long random(long max) {
+  uint32_t x = sim->random_state;           // xorshift32
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  sim->random_state = x;
+  return (max > 0) ? (long) (x % (uint32_t) max) : 0;
+}
+
+long random(long min, long max) { return min + random(max - min); }
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (sim_verbose) putchar(c);
+  return 1;
+}
+
+char & String::operator[](unsigned i) { return s[i]; }
+
+void wdt_disable() {}
+void wdt_enable(unsigned long) {}
+
+uint32_t EspClass::getChipId() { return sim->chip_id; }
+uint32_t EspClass::getFlashChipRealSize() { return 4 * 1024 * 1024; }
+uint32_t EspClass::getFlashChipSize() { return 4 * 1024 * 1024; }
+uint32_t EspClass::getFreeSketchSpace() { return 1024 * 1024; }
+uint32_t EspClass::getFreeHeap() { return 40000; }
+uint32_t EspClass::getCycleCount() { return (uint32_t) (sim->now_us * 80); }
+bool EspClass::updateSketch(Stream &, uint32_t, bool, bool) { return false; }
+
+void EspClass::restart() {
+  sim->sleeping = true;                     // the wake ends either way
+  sim->restarts++;
+  throw SimRestart();                       // nothing after it runs, like a reset
+}
+
+void EspClass::deepSleep(uint64_t us, int) {
+  sim->sleeping = true;
+  sim->sleep_us = us;
+}
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t * data, size_t size) {
+  if (offset * 4 + size > sizeof(sim->rtc)) return false;
+  memcpy(data, sim->rtc + offset * 4, size);
+  return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t * data, size_t size) {
+  if (offset * 4 + size > sizeof(sim->rtc)) return false;
+  memcpy(sim->rtc + offset * 4, data, size);
+  return true;
+}
+
+struct rst_info * EspClass::getResetInfoPtr() {
+  static struct rst_info info;
+  info.reason = sim->reset_reason;
+  return &info;
+}
+
+extern "C" {
+  int cont_get_free_stack(cont_t *) { return 4096; }
+  uint32_t system_get_free_heap_size(void) { return 40000; }
+  bool wifi_station_disconnect(void) { sim->wifi_connected = false; return true; }
+  struct rst_info * system_get_rst_info(void) { return ESP.getResetInfoPtr(); }
+  uint32_t system_get_time(void) { return (uint32_t) sim->now_us; }
+  bool system_rtc_mem_read(uint8_t block, void * data, uint16_t size) {
+    return ESP.rtcUserMemoryRead(block, (uint32_t *) data, size);
+  }
+  bool system_rtc_mem_write(uint8_t block, const void * data, uint16_t size) {
+    return ESP.rtcUserMemoryWrite(block, (uint32_t *) data, size);
+  }
+}
+
+void EEPROMClass::begin(size_t) {}
+uint8_t EEPROMClass::read(int i) { return sim->eeprom[i % sizeof(sim->eeprom)]; }
+void EEPROMClass::write(int i, uint8_t v) { sim->eeprom[i % sizeof(sim->eeprom)] = v; }
+bool EEPROMClass::commit() { return true; }
+uint8_t * EEPROMClass::getDataPtr() { return sim->eeprom; }
+
+bool FS::begin() { return true; }
+bool FS::format() { return true; }
+bool FS::exists(const char *) { return false; }
+bool FS::remove(const char *) { return false; }
+
+t_httpUpdate_return ESP8266HTTPUpdate::update(const String &, uint16_t, const String &, const String &) {
+  return HTTP_UPDATE_FAILED;
+}
+
+/*
+ * WiFi
+ */
+
+static wl_status_t sim_wifi_begin(bool fast) {
+  sim->wifi_connected = false;
+  sim->wifi_connecting = true;
+  sim->wifi_fast = fast;
+  sim->wifi_ready_us = sim->now_us + 1000ULL * (fast ? sim_link.fast_connect_ms : sim_link.scan_ms);
+  return WL_DISCONNECTED;
+}
+
+wl_status_t ESP8266WiFiClass::status() {
+  if (sim->wifi_connecting && (sim->now_us >= sim->wifi_ready_us)) {
+    sim->wifi_connecting = false;
+    sim->wifi_connected = true;
+  }
+  return sim->wifi_connected ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+wl_status_t ESP8266WiFiClass::begin() {
+  return sim_wifi_begin(false);
+}
+
+wl_status_t ESP8266WiFiClass::begin(const char *, const char *, int32_t channel, const uint8_t * bssid, bool) {
+  return sim_wifi_begin((channel != 0) && (bssid != NULL) && (sim->static_ip != 0));
+}
+
+bool ESP8266WiFiClass::config(IPAddress ip, IPAddress, IPAddress, IPAddress, IPAddress) {
+  sim->static_ip = ip;
+  return true;
+}
+
+WiFiMode_t ESP8266WiFiClass::getMode() { return WIFI_STA; }
+bool ESP8266WiFiClass::mode(WiFiMode_t) { return true; }
+String ESP8266WiFiClass::SSID() { return String("THiNX-IoT+"); }
+String ESP8266WiFiClass::psk() { return String("password"); }
+String ESP8266WiFiClass::BSSIDstr() { return String("02:00:00:00:00:01"); }
+int32_t ESP8266WiFiClass::channel() { return 6; }
+int32_t ESP8266WiFiClass::RSSI() { return -67; }
+IPAddress ESP8266WiFiClass::gatewayIP() { return IPAddress(10, 0, 0, 1); }
+IPAddress ESP8266WiFiClass::subnetMask() { return IPAddress(255, 255, 0, 0); }
+IPAddress ESP8266WiFiClass::dnsIP(uint8_t) { return IPAddress(10, 0, 0, 1); }
+bool ESP8266WiFiClass::softAP(const char *, const char *) { return true; }
+bool ESP8266WiFiClass::disconnect(bool) { sim->wifi_connected = false; return true; }
+bool ESP8266WiFiClass::setAutoConnect(bool) { return true; }
+bool ESP8266WiFiClass::forceSleepBegin() { return true; }
+bool ESP8266WiFiClass::forceSleepWake() { return true; }
+int ESP8266WiFiClass::hostByName(const char *, IPAddress & ip) { ip = IPAddress(10, 0, 0, 2); return 1; }
+
+bool ESP8266WiFiClass::persistent(bool persistent) {
+  sim->wifi_persistent = persistent;
+  return true;
+}
+
+bool ESP8266WiFiClass::getPersistent() { return sim->wifi_persistent; }
+
+uint8_t * ESP8266WiFiClass::BSSID() {
+  static uint8_t bssid[6] = { 0x02, 0, 0, 0, 0, 0x01 };
+  return bssid;
+}
+
+IPAddress ESP8266WiFiClass::localIP() {
+  if (sim->static_ip) return IPAddress(sim->static_ip);
+  return IPAddress(10, 0, (sim->chip_id >> 8) & 0xFF, sim->chip_id & 0xFF);
+}
+
+String ESP8266WiFiClass::macAddress() {
+  char mac[18];
+  snprintf(mac, sizeof(mac), "5C:CF:7F:%02X:%02X:%02X",
+           (sim->chip_id >> 16) & 0xFF, (sim->chip_id >> 8) & 0xFF, sim->chip_id & 0xFF);
+  return String(mac);
+}
+
+/*
+ * Servers
+ */
+
+struct SimChunk {
+  uint64_t at_us;                           // deliverable from
+  std::string data;
+};
+
+struct SimSocket {
+  bool api;                                 // API on 7442, else the broker
+  std::string in;                           // from the device, not handled yet
+  std::deque<SimChunk> out;                 // to the device
+  bool closing;
+  uint64_t close_us;
+  size_t accepted;                          // bytes taken from the device
+  bool queued_sent;                         // session messages delivered on this connection
+
+  void reply(uint32_t after_ms, const std::string & data) {
+    SimChunk chunk = { sim->now_us + after_ms * 1000ULL, data };
+    out.push_back(chunk);
+  }
+
+  void close(uint32_t after_ms) {
+    closing = true;
+    close_us = sim->now_us + after_ms * 1000ULL;
+  }
+
+  size_t ready() const {
+    size_t n = 0;
+    for (size_t i = 0; i < out.size() && out[i].at_us <= sim->now_us; i++) n += out[i].data.size();
+    return n;
+  }
+
+  void handle() {
+    if (api) {
+      handle_api();
+    } else {
+      while (handle_mqtt()) {}
+    }
+  }
+
+  // One POST /device/register per connection, answered and closed
+  void handle_api() {
+    size_t headers = in.find("\r\n\r\n");
+    if (headers == std::string::npos) return;
+    size_t length_at = in.find("Content-Length: ");
+    size_t length = (length_at < headers) ? atol(in.c_str() + length_at + 16) : 0;
+    if (in.size() < headers + 4 + length) return;
+
+    SimRequest request = { sim->chip_id, sim->now_us, in.find("If-None-Match:") < headers };
+    sim_requests.push_back(request);
+    sim->api_requests++;
+    in.clear();
+
+    if (request.conditional) {
+      reply(sim_link.api_ms, "HTTP/1.1 304 Not Modified\r\nConnection: close\r\n\r\n");
+    } else {
+      char body[256];
+      int n = snprintf(body, sizeof(body),
+        "{\"registration\":{\"success\":true,\"status\":\"OK\",\"alias\":\"sim\","
+        "\"owner\":\"sim-owner\",\"udid\":\"sim-%08x\"", sim->chip_id);
+      if (sim_link.checkin_slot > 0) {
+        n += snprintf(body + n, sizeof(body) - n, ",\"checkin_slot\":%ld", sim_link.checkin_slot);
+      }
+      snprintf(body + n, sizeof(body) - n, "}}");
+      reply(sim_link.api_ms, std::string("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                                         "Connection: close\r\n\r\n") + body);
+    }
+    close(sim_link.api_ms);
+  }
+
+  // Session messages not acknowledged yet, once per connection
+  void send_queued() {
+    if (queued_sent) return;
+    queued_sent = true;
+    std::deque<SimMessage> & queue = sim_queued[sim->chip_id];
+    for (size_t q = 0; q < queue.size(); q++) {
+      SimMessage & message = queue[q];
+      std::string body;
+      body += (char) (message.topic.size() >> 8);
+      body += (char) message.topic.size();
+      body += message.topic;
+      body += (char) (message.packet_id >> 8);
+      body += (char) message.packet_id;
+      body += message.payload;
+      std::string packet(1, (char) (0x32 | (message.delivered ? 0x08 : 0))); // PUBLISH, QoS 1
+      for (size_t length = body.size(); ; ) {
+        packet += (char) ((length & 0x7F) | ((length > 0x7F) ? 0x80 : 0));
+        length >>= 7;
+        if (length == 0) break;
+      }
+      reply(sim_link.broker_ms, packet + body);
+      message.delivered = true;
+    }
+  }
+
+  // Answers one complete packet, false when none is buffered
+  bool handle_mqtt() {
+    size_t length = 0, i = 1;
+    uint32_t multiplier = 1;
+    uint8_t byte;
+    do {
+      if (i >= in.size()) return false;
+      byte = in[i++];
+      length += (byte & 0x7F) * multiplier;
+      multiplier <<= 7;
+    } while (byte & 0x80);
+    if (in.size() < i + length) return false;
+
+    const uint8_t header = in[0];
+    const std::string body = in.substr(i, length);
+    in.erase(0, i + length);
+    const uint8_t * b = (const uint8_t *) body.data();
+
+    switch (header >> 4) {
+      case 1: {                             // CONNECT
+        size_t name = (b[0] << 8) | b[1];
+        bool clean = b[2 + name + 1] & 0x02;
+        bool present = !clean && sim_sessions.count(sim->chip_id);
+        if (clean) sim_sessions.erase(sim->chip_id); else sim_sessions.insert(sim->chip_id);
+        if (clean) sim_queued.erase(sim->chip_id);
+        sim->mqtt_connects++;
+        const char connack[] = { 0x20, 0x02, (char) present, 0x00 };
+        reply(sim_link.broker_ms, std::string(connack, sizeof(connack)));
+        if (present) send_queued();
+      } break;
+      case 3: {                             // PUBLISH
+        sim->mqtt_publishes++;
+        if (((header >> 1) & 3) == 1) {
+          size_t topic = (b[0] << 8) | b[1];
+          const char puback[] = { 0x40, 0x02, (char) b[2 + topic], (char) b[3 + topic] };
+          reply(sim_link.broker_ms, std::string(puback, sizeof(puback)));
+        }
+      } break;
+      case 4: {                             // PUBACK
+        std::deque<SimMessage> & queue = sim_queued[sim->chip_id];
+        uint16_t packet_id = (b[0] << 8) | b[1];
+        for (size_t q = 0; q < queue.size(); q++) {
+          if (queue[q].packet_id == packet_id) {
+            queue.erase(queue.begin() + q);
+            break;
+          }
+        }
+      } break;
+      case 8: {                             // SUBSCRIBE
+        std::string suback(1, (char) 0x90);
+        std::string granted;
+        for (size_t p = 2; p + 2 <= body.size();) {
+          size_t topic = (b[p] << 8) | b[p + 1];
+          p += 2 + topic;
+          granted += (char) (b[p++] & 3);
+        }
+        suback += (char) (2 + granted.size());
+        suback += body.substr(0, 2) + granted;
+        reply(sim_link.broker_ms, suback);
+        send_queued();
+      } break;
+      case 10: {                            // UNSUBSCRIBE
+        const char unsuback[] = { (char) 0xB0, 0x02, (char) b[0], (char) b[1] };
+        reply(sim_link.broker_ms, std::string(unsuback, sizeof(unsuback)));
+      } break;
+      case 12: {                            // PINGREQ
+        const char pingresp[] = { (char) 0xD0, 0x00 };
+        reply(sim_link.broker_ms, std::string(pingresp, sizeof(pingresp)));
+      } break;
+      case 14:                              // DISCONNECT
+        close(0);
+        break;
+    }
+    return true;
+  }
+};
+
+int WiFiClient::connect(IPAddress, uint16_t port) {
+  return connect("", port);
+}
+
+int WiFiClient::connect(const char *, uint16_t port) {
+  stop();
+  if (!sim->wifi_connected) return 0;
+  sim->now_us += sim_link.tcp_connect_ms * 1000ULL;
+  if ((port == 7442) && sim_link.api_down) return 0;
+  _socket = new SimSocket();
+  _socket->api = (port == 7442);
+  _socket->closing = false;
+  _socket->close_us = 0;
+  _socket->accepted = 0;
+  _socket->queued_sent = false;
+  return 1;
+}
+
+size_t WiFiClient::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t WiFiClient::write(const uint8_t * buf, size_t size) {
+  if (!connected()) return 0;
+  if (_socket->api && sim_link.api_accept_bytes) {
+    size_t room = sim_link.api_accept_bytes - std::min(_socket->accepted, (size_t) sim_link.api_accept_bytes);
+    size = std::min(size, room);
+  }
+  _socket->accepted += size;
+  _socket->in.append((const char *) buf, size);
+  sim->tx_bytes += size;
+  sim->radio_us += size * sim_link.byte_us;
+  sim->now_us += size * sim_link.byte_us;
+  _socket->handle();
+  return size;
+}
+
+int WiFiClient::available() {
+  if (_socket == NULL) return 0;
+  size_t n = _socket->ready();
+  if (n == 0) sim->now_us += 1000;          // polling an empty socket takes time
+  return n;
+}
+
+int WiFiClient::read() {
+  if ((_socket == NULL) || (_socket->ready() == 0)) return -1;
+  SimChunk & chunk = _socket->out.front();
+  uint8_t c = chunk.data[0];
+  chunk.data.erase(0, 1);
+  if (chunk.data.empty()) _socket->out.pop_front();
+  sim->rx_bytes++;
+  sim->radio_us += sim_link.byte_us;
+  return c;
+}
+
+int WiFiClient::read(uint8_t * buf, size_t size) {
+  size_t n = 0;
+  while (n < size) {
+    int c = read();
+    if (c < 0) break;
+    buf[n++] = c;
+  }
+  return n;
+}
+
+int WiFiClient::peek() {
+  if ((_socket == NULL) || (_socket->ready() == 0)) return -1;
+  return (uint8_t) _socket->out.front().data[0];
+}
+
+void WiFiClient::flush() {}
+
+void WiFiClient::stop() {
+  delete _socket;
+  _socket = NULL;
+}
+
+uint8_t WiFiClient::connected() {
+  if (_socket == NULL) return 0;
+  return !_socket->closing || (sim->now_us < _socket->close_us) || _socket->ready();
+}
+
+WiFiClient::operator bool() { return connected(); }
+void WiFiClient::setNoDelay(bool) {}
+void WiFiClient::setTimeout(unsigned long) {}
@@ -0,0 +1,78 @@
+// Simulated devices and network behind the mock Arduino core.
+//
+// Every device has its own clock, chip id, RTC memory, EEPROM and WiFi
+// state; sim_select() makes one of them current for the mocks. Time only
+// moves when the code waits: delay(), polling an empty socket, connecting.
+// The API and the MQTT broker are scripted servers shared by all devices.
+
+#ifndef THiNXSim_h
+#define THiNXSim_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+struct SimLink {
+  uint32_t scan_ms;                         // WiFi scan, association and DHCP
+  uint32_t fast_connect_ms;                 // directed association with a static lease
+  uint32_t tcp_connect_ms;                  // TCP handshake
+  uint32_t api_ms;                          // API processing until the response
+  uint32_t broker_ms;                       // broker round trip
+  uint32_t byte_us;                         // per byte on air
+  long checkin_slot;                        // slot hint sent with registrations, 0 = none
+  bool api_down;                            // refuse API connections
+  uint32_t api_accept_bytes;                // API sockets stall after this many bytes, 0 = never
+};
+
+struct SimDevice {
+  uint32_t chip_id;
+  uint64_t now_us;
+  uint32_t reset_reason;                    // REASON_DEEP_SLEEP_AWAKE after a wake
+  uint8_t rtc[512];                         // survives deep sleep
+  uint8_t eeprom[4096];                     // survives everything
+  uint32_t random_state;
+
+  // WiFi
+  bool wifi_connected;
+  bool wifi_connecting;
+  bool wifi_fast;                           // last association was directed
+  bool wifi_persistent;
+  uint64_t wifi_ready_us;
+  uint32_t static_ip;
+
+  // Results of the current wake
+  bool sleeping;                            // ESP.deepSleep() was called
+  uint64_t sleep_us;
+  uint64_t radio_us;                        // time on air of all bytes
+  uint32_t tx_bytes;
+  uint32_t rx_bytes;
+  uint16_t api_requests;
+  uint16_t mqtt_connects;
+  uint16_t mqtt_publishes;
+  uint16_t restarts;                        // ESP.restart() calls
+};
+
+struct SimRequest {
+  uint32_t chip_id;
+  uint64_t at_us;                           // device time when the request arrived
+  bool conditional;                         // If-None-Match, nothing changed
+};
+
+// Thrown by ESP.restart(), the wake loop catches it
+struct SimRestart {};
+
+extern SimLink sim_link;
+extern std::vector<SimRequest> sim_requests; // every API request of the run
+extern bool sim_verbose;                     // Serial output to stdout
+
+void sim_init(SimDevice & device, uint32_t chip_id);
+void sim_select(SimDevice & device);
+
+// Starts the next wake of the current device: clock at zero, counters reset
+void sim_wake(bool from_deep_sleep);
+
+// Queues a QoS 1 message in the broker session of a device, delivered on
+// every connection until the device acknowledges it
+void sim_queue(uint32_t chip_id, const char * topic, const char * payload);
+
+#endif
@@ -0,0 +1,10 @@
+#pragma once
+#include <stdint.h>
+uint32_t system_get_free_heap_size(void);
+bool wifi_station_disconnect(void);
+struct rst_info { uint32_t reason; };
+struct rst_info* system_get_rst_info(void);
+#define REASON_DEEP_SLEEP_AWAKE 5
+bool system_rtc_mem_read(uint8_t, void*, uint16_t);
+bool system_rtc_mem_write(uint8_t, const void*, uint16_t);
+uint32_t system_get_time(void);
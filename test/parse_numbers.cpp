@@ -0,0 +1,113 @@
+// ARDUINOJSON_PARSE_NUMBERS: text is kept (and read with strtol()/strtod())
+// unless a buffer asks for typed values, and parseFloat() matches
+// strtod()/strtof() bit for bit
+
+#include <ArduinoJson.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+
+#include "test.h"
+
+using namespace ArduinoJson;
+
+static const char * document =
+  "{\"a\":12,\"b\":-2,\"c\":1.50,\"d\":-0.001,\"e\":12345.678,\"f\":1e10,"
+  "\"g\":true,\"h\":null,\"i\":18446744073709551616,\"k\":0.0,\"l\":abc}";
+
+static void default_keeps_text() {
+  DynamicJsonBuffer buffer;
+  char json[256];
+  strcpy(json, document);
+  JsonObject & o = buffer.parseObject(json);
+  CHECK(o.success());
+  CHECK(!buffer.convertsNumbers());
+  CHECK(o["a"].as<const char *>() != NULL && strcmp(o["a"].as<const char *>(), "12") == 0);
+  CHECK(strcmp(o["c"].as<const char *>(), "1.50") == 0);
+  CHECK(strcmp(o["g"].as<const char *>(), "true") == 0);
+  CHECK(o["a"].as<long>() == 12 && o["a"].is<long>());
+  CHECK(o["c"].as<float>() == 1.5f && o["c"].is<float>());
+
+  // text keeps the libc semantics: leading spaces, saturation on overflow
+  char spaced[] = "[\" 42\"]";
+  JsonArray & a = buffer.parseArray(spaced);
+  CHECK(a[0].as<long>() == 42);
+  CHECK(o["i"].as<long>() == LONG_MAX && !o["i"].is<long>());
+}
+
+static void converted_when_asked() {
+  DynamicJsonBuffer buffer;
+  buffer.convertNumbers(true);
+  char json[256];
+  strcpy(json, document);
+  JsonObject & o = buffer.parseObject(json);
+  CHECK(o.success());
+  CHECK(o["a"].as<const char *>() == NULL);
+  CHECK(o["a"].as<long>() == 12 && o["a"].is<long>());
+  CHECK(o["b"].as<long>() == -2);
+  CHECK(o["c"].as<double>() == 1.5 && o["c"].is<double>());
+  CHECK(o["d"].as<double>() == -0.001);
+  CHECK(o["e"].as<double>() == 12345.678);
+  CHECK(o["f"].as<double>() == 1e10);
+  CHECK(o["g"].as<bool>() && o["g"].is<bool>());
+  CHECK(o["h"].as<const char *>() == NULL);
+  CHECK(strcmp(o["l"].as<const char *>(), "abc") == 0);
+
+  // printed back with the precision of the literal
+  char out[256];
+  o["c"].printTo(out, sizeof(out));
+  CHECK(strcmp(out, "1.50") == 0);
+  o["d"].printTo(out, sizeof(out));
+  CHECK(strcmp(out, "-0.001") == 0);
+}
+
+static bool same(double a, double b) {
+  return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+static bool same(float a, float b) {
+  return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+static void floats_match_strtod() {
+  std::mt19937_64 random(1);
+  int mismatches = 0;
+  for (int i = 0; i < 200000; i++) {
+    char literal[64];
+    double value = ldexp((double) (random() >> 11), (int) (random() % 2000) - 1100);
+    snprintf(literal, sizeof(literal), "%.*g", 1 + (int) (random() % 20), value);
+    if (!same(Polyfills::parseFloat<double>(literal), strtod(literal, NULL))) mismatches++;
+    if (!same(Polyfills::parseFloat<float>(literal), strtof(literal, NULL))) mismatches++;
+  }
+  CHECK(mismatches == 0);
+
+  // halfway and boundary cases a scaled approximation gets wrong
+  static const char * hard[] = {
+    "9007199254740993", "2.2250738585072011e-308", "4.9406564584124654e-324", "1.7976931348623157e308",
+    "0.1e-30", "123456789012345678901234567890", "8.589973e9", "1.00000005960464477539062",
+    "-0.0", "7.038531e-26", "3.4028236e38", "1e400", "1e-400"
+  };
+  for (size_t i = 0; i < sizeof(hard) / sizeof(hard[0]); i++) {
+    CHECK(same(Polyfills::parseFloat<double>(hard[i]), strtod(hard[i], NULL)));
+    CHECK(same(Polyfills::parseFloat<float>(hard[i]), strtof(hard[i], NULL)));
+  }
+
+  // telemetry range: exact for float and double
+  mismatches = 0;
+  for (int i = 0; i < 200000; i++) {
+    char literal[64];
+    snprintf(literal, sizeof(literal), "%lde%d", (long) (random() % 100000000), (int) (random() % 15) - 10);
+    if (!same(Polyfills::parseFloat<double>(literal), strtod(literal, NULL))) mismatches++;
+    if (!same(Polyfills::parseFloat<float>(literal), strtof(literal, NULL))) mismatches++;
+  }
+  CHECK(mismatches == 0);
+}
+
+int main() {
+  default_keeps_text();
+  converted_when_asked();
+  floats_match_strtod();
+  return test_result("parse_numbers");
+}
@@ -0,0 +1,21 @@
+// Minimal checks for the host tests, see Makefile
+#ifndef THiNXTest_h
+#define THiNXTest_h
+
+#include <stdio.h>
+
+static int test_failures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      test_failures++; \
+    } \
+  } while (0)
+
+static inline int test_result(const char * name) {
+  printf("%s: %s\n", name, test_failures ? "FAILED" : "ok");
+  return test_failures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,127 @@
+// Deep-sleep duty cycle over simulated wakes: the first wake registers over
+// HTTP, later ones restore the session from RTC memory and fast-connect,
+// every THINX_DUTY_CYCLE_CHECKIN wakes a check-in refreshes it
+
+#include <THiNXLib.h>
+
+#include "mock/sim.h"
+#include "test.h"
+
+static const char * apikey = "4721f08a6df1a36b8517f678768effa8b3f2e53a7a1934423c1f42758dd83db5";
+
+static SimDevice device;
+
+// Runs one wake until the device sleeps, like setup() and loop() of a sketch
+static void wake(bool from_deep_sleep, bool assign = false) {
+  sim_wake(from_deep_sleep);
+  THiNX * thx = new THiNX(); // never deleted, a reset does not either
+  if (assign) {
+    *thx = THiNX(apikey); // deprecated form of the sketches before init()
+  } else {
+    thx->init(apikey);
+  }
+  thx->setDutyCycle(60);
+  try {
+    while (!device.sleeping && (millis() < 60000)) {
+      thx->loop();
+      delay(1);
+    }
+  } catch (SimRestart &) {
+  }
+}
+
+static void report(const char * name, unsigned long awake_ms, unsigned long radio_us, int wakes) {
+  printf("  %-22s %6lu ms awake, %5lu us on air per wake (%d wakes)\n",
+         name, awake_ms / wakes, radio_us / wakes, wakes);
+}
+
+int main() {
+
+  sim_init(device, 0x00A1B2C3);
+  sim_select(device);
+
+  unsigned long restored_ms = 0, restored_radio = 0, checkin_ms = 0, checkin_radio = 0;
+  int restored = 0, checkins = 0;
+
+  // Power-on: scan, DHCP, full registration, MQTT session created
+  wake(false);
+  const unsigned long first_ms = millis();
+  CHECK(device.sleeping && (device.sleep_us == 60000000ULL));
+  CHECK(device.api_requests == 1 && !sim_requests.back().conditional);
+  CHECK(device.mqtt_connects == 1 && device.mqtt_publishes > 0);
+  CHECK(!device.wifi_fast);
+  report("power-on", first_ms, device.radio_us, 1);
+
+  for (int i = 1; i <= 2 * THINX_DUTY_CYCLE_CHECKIN; i++) {
+    wake(true);
+    CHECK(device.sleeping);
+    CHECK(device.wifi_fast);
+    CHECK(device.mqtt_connects == 1 && device.mqtt_publishes > 0);
+    if (i % THINX_DUTY_CYCLE_CHECKIN) {
+      CHECK(device.api_requests == 0); // session from RTC, no HTTP
+      CHECK(millis() < first_ms);
+      restored_ms += millis();
+      restored_radio += device.radio_us;
+      restored++;
+    } else {
+      CHECK(device.api_requests == 1);
+      // first refresh sends the registration the API changed, then it is acknowledged
+      CHECK(sim_requests.back().conditional == (i > THINX_DUTY_CYCLE_CHECKIN));
+      checkin_ms += millis();
+      checkin_radio += device.radio_us;
+      checkins++;
+    }
+  }
+  report("session from RTC", restored_ms, restored_radio, restored);
+  report("periodic check-in", checkin_ms, checkin_radio, checkins);
+
+  // A corrupted session is not trusted
+  device.rtc[THINX_RTC_SESSION * 4 + 8] ^= 0xFF;
+  wake(true);
+  CHECK(device.sleeping && (device.api_requests == 1));
+
+  // Unreachable API: the wake still ends within THINX_DUTY_CYCLE_TIMEOUT
+  sim_link.api_down = true;
+  device.rtc[THINX_RTC_SESSION * 4 + 8] ^= 0xFF;
+  wake(false);
+  CHECK(device.sleeping && (millis() < THINX_DUTY_CYCLE_TIMEOUT + 100));
+  sim_link.api_down = false;
+
+  // A short write drops the check-in instead of waiting for a reply to it
+  sim_link.api_accept_bytes = 200;
+  device.rtc[THINX_RTC_SESSION * 4 + 8] ^= 0xFF;
+  wake(false);
+  CHECK(device.sleeping && (device.api_requests == 0) && (millis() < 10000));
+  sim_link.api_accept_bytes = 0;
+
+  // Fast connect leaves the application's persistence setting alone
+  device.wifi_persistent = false;
+  wake(true);
+  CHECK(device.wifi_fast && !device.wifi_persistent);
+
+  // A reboot command is acknowledged before the device restarts, so the
+  // resumed session does not hand it out again
+  char reboot[64];
+  snprintf(reboot, sizeof(reboot), "/sim-owner/sim-%08x/command/reboot", device.chip_id);
+  sim_queue(device.chip_id, reboot, "");
+  wake(true);
+  CHECK(device.restarts == 1);
+  wake(false);
+  CHECK(device.sleeping && (device.restarts == 0) && (device.mqtt_connects == 1));
+
+  // A command that happens to start with "LZ" is not taken for a compressed
+  // frame by a device whose server does not compress
+  sim_queue(device.chip_id, reboot, "LZ-now");
+  wake(true);
+  CHECK(device.restarts == 1);
+  wake(false);
+
+  // `thx = THiNX(apikey);` still works, callbacks reach the assigned object
+  wake(true, true);
+  CHECK(device.sleeping && (device.sleep_us == 60000000ULL) && (device.mqtt_connects == 1));
+  sim_queue(device.chip_id, reboot, "");
+  wake(true, true);
+  CHECK(device.restarts == 1);
+
+  return test_result("wake_cycle");
+}